@@ -0,0 +1,483 @@
+// Copyright Necula Mihail 313CAa 2023-2024
+#include <fcntl.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include "driver.h"
+#include "utils.h"
+
+/* The number of different contents made for the edits. */
+#define WL_CONTENTS			256
+/* The number of types of requests (see request_type). */
+#define WL_TYPES			4
+
+/******************************
+ * The distributions after which the docs of the requests are chosen.
+*******************************/
+typedef enum wl_dist_t {
+	/* Every doc has the same chance. */
+	WL_UNIFORM,
+	/* The doc with the rank k has a chance proportional with
+	1 / k^zipf_s. */
+	WL_ZIPF,
+	/* hot_ops of the requests go to the first hot_docs of the docs,
+	the others to the rest of the docs. */
+	WL_HOTSPOT
+} wl_dist_t;
+
+/******************************
+ * The parameters of a workload (see bench_usage()).
+*******************************/
+typedef struct wl_config_t {
+	/* The number of measured requests. */
+	u_int ops;
+	/* The number of docs. */
+	u_int docs;
+	/* The distribution of the docs. */
+	wl_dist_t dist;
+	/* The exponent of the Zipf distribution. */
+	double zipf_s;
+	/* The part of the docs which are hot and the part of the requests
+	which go to them. */
+	double hot_docs;
+	double hot_ops;
+	/* The part of the requests for docs which are GETs. */
+	double get_ratio;
+	/* The part of the requests which add / remove a server. */
+	double churn;
+	/* The number of servers at the start and the size of their caches. */
+	u_int servers;
+	u_int cache_size;
+	/* The mean length of a content (the lengths are from
+	[doc_size / 2, 3 * doc_size / 2]). */
+	u_int doc_size;
+	/* The number of replicas of a server (1 -> without virtual nodes). */
+	u_int replicas;
+	/* The options of tema2. */
+	u_int threads;
+	bool targeted_flush;
+	bool compress;
+	const hash_family_t *hash;
+	/* The seed of the random numbers. */
+	uint64_t seed;
+} wl_config_t;
+
+/******************************
+ * The state of the generator of requests.
+*******************************/
+typedef struct workload_t {
+	/* The state of the random numbers (xorshift64*). */
+	uint64_t rng;
+	/* The names of the docs and their memory. */
+	char **names;
+	char *names_buff;
+	/* The contents used by the edits (they live until the end, like
+	an input file). */
+	char *contents[WL_CONTENTS];
+	/* The cumulative chances of the docs (for WL_ZIPF). */
+	double *zipf_cdf;
+	/* The ids of the servers from the ring. */
+	u_int *servers;
+	u_int servers_num;
+	/* The id of the next added server. */
+	u_int next_server;
+} workload_t;
+
+/******************************
+ * The latencies of the requests of a type, in nanoseconds.
+*******************************/
+typedef struct wl_latency_t {
+	uint64_t *ns;
+	u_int size;
+} wl_latency_t;
+
+static const char *wl_type_names[WL_TYPES] = {
+	"EDIT", "GET", "ADD_SERVER", "REMOVE_SERVER"
+};
+
+static const char *wl_words[] = {
+	"lorem", "ipsum", "dolor", "sit", "amet", "consectetur", "adipiscing",
+	"elit", "sed", "do", "eiusmod", "tempor", "incididunt", "ut", "labore",
+	"et", "dolore", "magna", "aliqua", "server", "cache", "document"
+};
+
+// The next random number.
+static uint64_t wl_rand(workload_t *wl)
+{
+	wl->rng ^= wl->rng >> 12;
+	wl->rng ^= wl->rng << 25;
+	wl->rng ^= wl->rng >> 27;
+	return wl->rng * 2685821657736338717ull;
+}
+
+// A random number from [0, 1).
+static double wl_rand_double(workload_t *wl)
+{
+	return (double)(wl_rand(wl) >> 11) / (double)(1ull << 53);
+}
+
+// A random number from [0, n).
+static u_int wl_rand_below(workload_t *wl, u_int n)
+{
+	return (u_int)(wl_rand(wl) % n);
+}
+
+// The current time, in nanoseconds.
+static uint64_t wl_now(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000 + (uint64_t)ts.tv_nsec;
+}
+
+// Make up the names of the docs, the contents of the edits and the
+// chances of the docs.
+static void wl_create(workload_t *wl, const wl_config_t *cfg)
+{
+	wl->rng = cfg->seed ? cfg->seed : 1;
+
+	// The names.
+	wl->names = (char **)malloc(cfg->docs * sizeof(char *));
+	wl->names_buff = (char *)malloc((size_t)cfg->docs * DOC_NAME_LENGTH);
+	DIE(!wl->names || !wl->names_buff, "malloc() failed\n");
+	for (u_int i = 0; i < cfg->docs; ++i) {
+		wl->names[i] = wl->names_buff + (size_t)i * DOC_NAME_LENGTH;
+		snprintf(wl->names[i], DOC_NAME_LENGTH, "doc_%u.txt", i);
+	}
+
+	// The contents, made of words (and a few new lines).
+	u_int words_num = sizeof(wl_words) / sizeof(wl_words[0]);
+	for (u_int i = 0; i < WL_CONTENTS; ++i) {
+		u_int len = cfg->doc_size / 2 + wl_rand_below(wl, cfg->doc_size + 1);
+		if (!len)
+			len = 1;
+		char *content = (char *)malloc(len + 1);
+		DIE(content == NULL, "malloc() failed\n");
+		u_int pos = 0;
+		while (pos < len) {
+			const char *word = wl_words[wl_rand_below(wl, words_num)];
+			for (u_int j = 0; word[j] && pos < len; ++j)
+				content[pos++] = word[j];
+			if (pos < len)
+				content[pos++] = wl_rand_below(wl, 16) ? ' ' : '\n';
+		}
+		content[len] = '\0';
+		wl->contents[i] = content;
+	}
+
+	// The cumulative chances of the Zipf distribution.
+	wl->zipf_cdf = NULL;
+	if (cfg->dist == WL_ZIPF) {
+		wl->zipf_cdf = (double *)malloc(cfg->docs * sizeof(double));
+		DIE(wl->zipf_cdf == NULL, "malloc() failed\n");
+		double sum = 0;
+		for (u_int i = 0; i < cfg->docs; ++i) {
+			sum += 1.0 / pow(i + 1, cfg->zipf_s);
+			wl->zipf_cdf[i] = sum;
+		}
+		for (u_int i = 0; i < cfg->docs; ++i)
+			wl->zipf_cdf[i] /= sum;
+	}
+
+	// The servers from the start.
+	wl->servers = (u_int *)malloc((cfg->servers + cfg->ops + 1) *
+								  sizeof(u_int));
+	DIE(wl->servers == NULL, "malloc() failed\n");
+	wl->servers_num = 0;
+	wl->next_server = 0;
+}
+
+// Free the memory of a workload.
+static void wl_free(workload_t *wl)
+{
+	free(wl->names);
+	free(wl->names_buff);
+	for (u_int i = 0; i < WL_CONTENTS; ++i)
+		free(wl->contents[i]);
+	free(wl->zipf_cdf);
+	free(wl->servers);
+}
+
+// Choose a doc after the distribution of the workload.
+static u_int wl_pick_doc(workload_t *wl, const wl_config_t *cfg)
+{
+	if (cfg->dist == WL_ZIPF) {
+		// The first doc whose cumulative chance is greater.
+		double r = wl_rand_double(wl);
+		u_int left = 0, right = cfg->docs - 1;
+		while (left < right) {
+			u_int mid = left + (right - left) / 2;
+			if (wl->zipf_cdf[mid] > r)
+				right = mid;
+			else
+				left = mid + 1;
+		}
+		return left;
+	}
+
+	if (cfg->dist == WL_HOTSPOT) {
+		u_int hot = (u_int)(cfg->hot_docs * cfg->docs);
+		if (!hot)
+			hot = 1;
+		if (hot > cfg->docs)
+			hot = cfg->docs;
+		if (hot == cfg->docs || wl_rand_double(wl) < cfg->hot_ops)
+			return wl_rand_below(wl, hot);
+		return hot + wl_rand_below(wl, cfg->docs - hot);
+	}
+
+	return wl_rand_below(wl, cfg->docs);
+}
+
+// Make a request which adds a server.
+static void wl_add_server(workload_t *wl, const wl_config_t *cfg,
+						  parsed_request_t *req)
+{
+	req->type = ADD_SERVER;
+	req->server_id = (int)wl->next_server++;
+	req->cache_size = (int)cfg->cache_size;
+	req->weight = 1;
+	wl->servers[wl->servers_num++] = (u_int)req->server_id;
+}
+
+// Make up the next request.
+static void wl_next(workload_t *wl, const wl_config_t *cfg,
+					parsed_request_t *req)
+{
+	memset(req, 0, sizeof(*req));
+	req->doc_id = -1;
+
+	// A change of the servers. (At least one server remains.)
+	if (wl_rand_double(wl) < cfg->churn) {
+		if (wl->servers_num <= 1 || wl_rand_below(wl, 2)) {
+			wl_add_server(wl, cfg, req);
+		} else {
+			u_int i = wl_rand_below(wl, wl->servers_num);
+			req->type = REMOVE_SERVER;
+			req->server_id = (int)wl->servers[i];
+			wl->servers[i] = wl->servers[--wl->servers_num];
+		}
+		return;
+	}
+
+	// A request for a doc.
+	req->doc_name = wl->names[wl_pick_doc(wl, cfg)];
+	if (wl_rand_double(wl) < cfg->get_ratio) {
+		req->type = GET_DOCUMENT;
+	} else {
+		req->type = EDIT_DOCUMENT;
+		req->doc_content = wl->contents[wl_rand_below(wl, WL_CONTENTS)];
+	}
+}
+
+// Compare 2 latencies (for qsort()).
+static int wl_cmp_ns(const void *a, const void *b)
+{
+	uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+
+	return (x > y) - (x < y);
+}
+
+// The latency below which are the given part of the requests (the
+// latencies must be sorted).
+static uint64_t wl_percentile(wl_latency_t *lat, double p)
+{
+	u_int rank = (u_int)ceil(p * lat->size);
+	return lat->ns[rank ? rank - 1 : 0];
+}
+
+// Print the parameters of the program and stop it.
+static void bench_usage(const char *name)
+{
+	fprintf(stderr,
+		"Usage: %s [options]\n"
+		"  --ops <n>            measured requests (200000)\n"
+		"  --docs <n>           docs (10000)\n"
+		"  --dist <d>           uniform, zipf or hotspot (uniform)\n"
+		"  --zipf-s <s>         exponent of zipf (0.99)\n"
+		"  --hot <docs> <ops>   hotspot: parts of docs and requests (0.1 0.9)\n"
+		"  --get-ratio <r>      part of GETs (0.9)\n"
+		"  --churn <r>          part of ADD / REMOVE_SERVER (0.0001)\n"
+		"  --servers <n>        servers at the start (10)\n"
+		"  --cache <n>          cache size of a server (100)\n"
+		"  --doc-size <n>       mean length of a content (256)\n"
+		"  --vnodes <n>         replicas of a server, 1 -> off (3)\n"
+		"  --threads <n>        worker threads (0)\n"
+		"  --targeted-flush, --compress, --hash <name>, --seed <n>\n",
+		name);
+	exit(1);
+}
+
+// Read the parameters of the workload.
+static void bench_parse(int argc, char **argv, wl_config_t *cfg)
+{
+	*cfg = (wl_config_t){
+		.ops = 200000, .docs = 10000, .dist = WL_UNIFORM, .zipf_s = 0.99,
+		.hot_docs = 0.1, .hot_ops = 0.9, .get_ratio = 0.9, .churn = 0.0001,
+		.servers = 10, .cache_size = 100, .doc_size = 256,
+		.replicas = DEFAULT_REPLICAS, .hash = &hash_families[0], .seed = 42
+	};
+
+	for (int i = 1; i < argc; ++i) {
+		const char *opt = argv[i];
+		bool has_arg = i + 1 < argc;
+		if (!strcmp(opt, "--ops") && has_arg) {
+			cfg->ops = (u_int)atoi(argv[++i]);
+		} else if (!strcmp(opt, "--docs") && has_arg) {
+			cfg->docs = (u_int)atoi(argv[++i]);
+		} else if (!strcmp(opt, "--dist") && has_arg) {
+			const char *dist = argv[++i];
+			if (!strcmp(dist, "uniform"))
+				cfg->dist = WL_UNIFORM;
+			else if (!strcmp(dist, "zipf"))
+				cfg->dist = WL_ZIPF;
+			else if (!strcmp(dist, "hotspot"))
+				cfg->dist = WL_HOTSPOT;
+			else
+				bench_usage(argv[0]);
+		} else if (!strcmp(opt, "--zipf-s") && has_arg) {
+			cfg->zipf_s = atof(argv[++i]);
+		} else if (!strcmp(opt, "--hot") && i + 2 < argc) {
+			cfg->hot_docs = atof(argv[++i]);
+			cfg->hot_ops = atof(argv[++i]);
+		} else if (!strcmp(opt, "--get-ratio") && has_arg) {
+			cfg->get_ratio = atof(argv[++i]);
+		} else if (!strcmp(opt, "--churn") && has_arg) {
+			cfg->churn = atof(argv[++i]);
+		} else if (!strcmp(opt, "--servers") && has_arg) {
+			cfg->servers = (u_int)atoi(argv[++i]);
+		} else if (!strcmp(opt, "--cache") && has_arg) {
+			cfg->cache_size = (u_int)atoi(argv[++i]);
+		} else if (!strcmp(opt, "--doc-size") && has_arg) {
+			cfg->doc_size = (u_int)atoi(argv[++i]);
+		} else if (!strcmp(opt, "--vnodes") && has_arg) {
+			cfg->replicas = (u_int)atoi(argv[++i]);
+		} else if (!strcmp(opt, THREADS_OPTION) && has_arg) {
+			cfg->threads = (u_int)atoi(argv[++i]);
+		} else if (!strcmp(opt, TARGETED_FLUSH_OPTION)) {
+			cfg->targeted_flush = true;
+		} else if (!strcmp(opt, COMPRESS_OPTION)) {
+			cfg->compress = true;
+		} else if (!strcmp(opt, HASH_OPTION) && has_arg) {
+			cfg->hash = get_hash_family(argv[++i]);
+			DIE(!cfg->hash, "unknown hash family");
+		} else if (!strcmp(opt, "--seed") && has_arg) {
+			cfg->seed = (uint64_t)strtoull(argv[++i], NULL, 10);
+		} else {
+			bench_usage(argv[0]);
+		}
+	}
+
+	if (!cfg->docs || !cfg->servers || !cfg->replicas)
+		bench_usage(argv[0]);
+}
+
+// Print the parameters of the workload.
+static void bench_print_config(const wl_config_t *cfg)
+{
+	printf("workload: %u ops, %u docs, ", cfg->ops, cfg->docs);
+	if (cfg->dist == WL_ZIPF)
+		printf("zipf (s = %.2f)", cfg->zipf_s);
+	else if (cfg->dist == WL_HOTSPOT)
+		printf("hotspot (%.0f%% of ops on %.0f%% of docs)",
+			   100 * cfg->hot_ops, 100 * cfg->hot_docs);
+	else
+		printf("uniform");
+	printf(", %.0f%% GET, churn %g\n", 100 * cfg->get_ratio, cfg->churn);
+	printf("servers: %u (cache %u), vnodes %u, doc size %u, threads %u, "
+		   "hash %s%s%s\n\n", cfg->servers, cfg->cache_size, cfg->replicas,
+		   cfg->doc_size, cfg->threads, cfg->hash->name,
+		   cfg->targeted_flush ? ", targeted flush" : "",
+		   cfg->compress ? ", compress" : "");
+}
+
+int main(int argc, char **argv)
+{
+	wl_config_t cfg;
+	workload_t wl;
+	bench_parse(argc, argv, &cfg);
+	bench_print_config(&cfg);
+	wl_create(&wl, &cfg);
+
+	// The responses are written like by tema2, but nowhere.
+	int null_fd = open("/dev/null", O_WRONLY);
+	DIE(null_fd < 0, "open() failed");
+	output_open(null_fd, OUTPUT_TEXT);
+
+	load_balancer_t *lb = init_load_balancer(cfg.replicas, cfg.hash);
+	lb->targeted_flush = cfg.targeted_flush;
+	lb->compress = cfg.compress;
+	worker_pool_t *pool = cfg.threads ? worker_pool_create(cfg.threads)
+									  : NULL;
+
+	// The servers from the start aren't measured.
+	parsed_request_t req;
+	for (u_int i = 0; i < cfg.servers; ++i) {
+		memset(&req, 0, sizeof(req));
+		wl_add_server(&wl, &cfg, &req);
+		apply_request(lb, pool, &req);
+	}
+
+	wl_latency_t lat[WL_TYPES];
+	for (u_int t = 0; t < WL_TYPES; ++t) {
+		lat[t].ns = (uint64_t *)malloc((cfg.ops + 1) * sizeof(uint64_t));
+		DIE(lat[t].ns == NULL, "malloc() failed\n");
+		lat[t].size = 0;
+	}
+
+	// Do the requests, measuring every one of them.
+	uint64_t start = wl_now();
+	for (u_int i = 0; i < cfg.ops; ++i) {
+		wl_next(&wl, &cfg, &req);
+		uint64_t t0 = wl_now();
+		apply_request(lb, pool, &req);
+		uint64_t t1 = wl_now();
+		lat[req.type].ns[lat[req.type].size++] = t1 - t0;
+	}
+	if (pool)
+		worker_pool_wait(pool);
+	uint64_t total_ns = wl_now() - start;
+
+	// Print the results.
+	printf("throughput: %.0f ops/s (%.3f s)\n\n",
+		   total_ns ? cfg.ops * 1e9 / total_ns : 0, total_ns / 1e9);
+	printf("%-14s %10s %10s %10s %10s\n", "type", "count", "p50 ns",
+		   "p99 ns", "p999 ns");
+	for (u_int t = 0; t < WL_TYPES; ++t) {
+		if (!lat[t].size)
+			continue;
+		qsort(lat[t].ns, lat[t].size, sizeof(uint64_t), wl_cmp_ns);
+		printf("%-14s %10u %10llu %10llu %10llu\n", wl_type_names[t],
+			   lat[t].size,
+			   (unsigned long long)wl_percentile(&lat[t], 0.5),
+			   (unsigned long long)wl_percentile(&lat[t], 0.99),
+			   (unsigned long long)wl_percentile(&lat[t], 0.999));
+	}
+	if (pool)
+		printf("(with threads, the latency of a GET / EDIT is the time to "
+			   "send it to its worker)\n");
+
+	if (pool)
+		worker_pool_free(&pool);
+	loader_flush_servers(lb);
+	if (cfg.compress) {
+		printf("\n");
+		loader_print_stats(lb, stdout);
+	}
+
+	struct rusage usage;
+	getrusage(RUSAGE_SELF, &usage);
+	printf("\npeak RSS: %ld KiB\n", usage.ru_maxrss);
+
+	// Free the memory.
+	free_load_balancer(&lb);
+	pool_cleanup();
+	output_close();
+	close(null_fd);
+	for (u_int t = 0; t < WL_TYPES; ++t)
+		free(lat[t].ns);
+	wl_free(&wl);
+
+	return 0;
+}
@@ -0,0 +1,161 @@
+// Copyright Necula Mihail 313CAa 2023-2024
+#include "blob.h"
+
+// Create a blob without content, with a reference.
+static blob_t *blob_create(void)
+{
+	blob_t *blob = (blob_t *)pool_alloc(sizeof(blob_t));
+	blob->refs = 1;
+	blob->data = NULL;
+	blob->chunks = NULL;
+	blob->size = 0;
+	blob->packed_size = 0;
+	return blob;
+}
+
+// Create a chunk which can keep len bytes.
+static blob_chunk_t *blob_chunk_alloc(u_int len)
+{
+	blob_chunk_t *chunk = (blob_chunk_t *)pool_alloc(sizeof(blob_chunk_t)
+													 + len);
+	chunk->next = NULL;
+	return chunk;
+}
+
+// Find the bytes of a chunk (they are after the structure).
+static char *blob_chunk_data(blob_chunk_t *chunk)
+{
+	return (char *)(chunk + 1);
+}
+
+blob_t *blob_wrap(const char *data)
+{
+	// Allocate memory just for the blob's structure.
+	blob_t *blob = blob_create();
+
+	// The caller has the first reference. The length is found only
+	// if it's needed.
+	blob->data = data;
+
+	// Return the created blob.
+	return blob;
+}
+
+u_int blob_size(blob_t *blob)
+{
+	if (!blob->size && blob->data)
+		blob->size = (u_int)strlen(blob->data);
+	return blob->size;
+}
+
+blob_t *blob_pack(blob_t *blob)
+{
+	if (blob->packed_size)
+		return NULL;
+
+	// Find the length of the content.
+	u_int size = blob_size(blob);
+	if (size < BLOB_MIN_PACK_SIZE)
+		return NULL;
+
+	blob_t *packed = blob_create();
+	packed->size = size;
+	blob_chunk_t **tail = &packed->chunks;
+	blob_chunk_t *src = blob->chunks;
+	u_int packed_size = 0;
+	char tmp[BLOB_CHUNK_SIZE];
+
+	// Compress separately every piece of BLOB_CHUNK_SIZE bytes (from
+	// the input or from a chunk).
+	for (u_int pos = 0; pos < size;) {
+		const char *piece;
+		u_int len;
+		if (blob->data) {
+			piece = blob->data + pos;
+			len = size - pos < BLOB_CHUNK_SIZE ? size - pos : BLOB_CHUNK_SIZE;
+		} else {
+			piece = blob_chunk_data(src);
+			len = src->size;
+			src = src->next;
+		}
+		pos += len;
+
+		// A piece which doesn't become smaller is kept how it is.
+		u_int len_packed = lz_compress(piece, len, tmp, len - 1);
+		u_int kept = len_packed ? len_packed : len;
+		blob_chunk_t *chunk = blob_chunk_alloc(kept);
+		chunk->size = len;
+		chunk->packed_size = len_packed;
+		memcpy(blob_chunk_data(chunk), len_packed ? tmp : piece, kept);
+		*tail = chunk;
+		tail = &chunk->next;
+		packed_size += kept;
+	}
+
+	// The content must become smaller.
+	if (packed_size >= size) {
+		blob_put(packed);
+		return NULL;
+	}
+	packed->packed_size = packed_size;
+
+	// Return the compressed blob.
+	return packed;
+}
+
+blob_t *blob_unpack(blob_t *blob)
+{
+	blob_t *unpacked = blob_create();
+	unpacked->size = blob->size;
+	blob_chunk_t **tail = &unpacked->chunks;
+
+	// Decompress every chunk in a new chunk.
+	for (blob_chunk_t *src = blob->chunks; src; src = src->next) {
+		blob_chunk_t *chunk = blob_chunk_alloc(src->size);
+		chunk->size = src->size;
+		chunk->packed_size = 0;
+		if (src->packed_size) {
+			bool ok = lz_decompress(blob_chunk_data(src), src->packed_size,
+									blob_chunk_data(chunk), src->size);
+			DIE(!ok, "damaged compressed content\n");
+		} else {
+			memcpy(blob_chunk_data(chunk), blob_chunk_data(src), src->size);
+		}
+		*tail = chunk;
+		tail = &chunk->next;
+	}
+
+	// Return the decompressed blob.
+	return unpacked;
+}
+
+void blob_output(blob_t *blob)
+{
+	if (blob->data) {
+		output_response_part(blob->data, blob_size(blob));
+		return;
+	}
+
+	for (blob_chunk_t *chunk = blob->chunks; chunk; chunk = chunk->next)
+		output_response_part(blob_chunk_data(chunk), chunk->size);
+}
+
+blob_t *blob_get(blob_t *blob)
+{
+	blob->refs++;
+	return blob;
+}
+
+void blob_put(blob_t *blob)
+{
+	if (!blob || --blob->refs)
+		return;
+
+	// Free the chunks and the structure.
+	while (blob->chunks) {
+		blob_chunk_t *next = blob->chunks->next;
+		pool_free(blob->chunks);
+		blob->chunks = next;
+	}
+	pool_free(blob);
+}
@@ -0,0 +1,116 @@
+// Copyright Necula Mihail 313CAa 2023-2024
+#ifndef BLOB_H
+#define BLOB_H
+
+#include "mem_pool.h"
+#include "lz.h"
+#include "utils.h"
+
+/* The shorter contents aren't compressed. */
+#define BLOB_MIN_PACK_SIZE	64
+/* The size of the block of a chunk (a size class of the pool). */
+#define BLOB_CHUNK_BLOCK	4096
+/* The most bytes of content kept in a chunk. */
+#define BLOB_CHUNK_SIZE		(BLOB_CHUNK_BLOCK - sizeof(blob_chunk_t))
+
+/******************************
+ * A piece of the content owned by a blob. The bytes are kept after
+ * the structure, in the same block of the pool.
+*******************************/
+typedef struct blob_chunk_t {
+	/* The next piece of the content. */
+	struct blob_chunk_t *next;
+	/* The number of bytes of content from this piece. */
+	u_int size;
+	/* The number of bytes kept, if they are compressed (0 -> the
+	bytes aren't compressed). */
+	u_int packed_size;
+} blob_chunk_t;
+
+/******************************
+ * An immutable content of a document, shared by the requests from
+ * the task queue, the docs and the responses of the GETs. Every owner
+ * has a reference; the blob is freed when the last one is given back.
+ * An edit doesn't modify a blob: the doc receives the blob of the
+ * edit. A blob is used only by the thread of its server (or by the
+ * load balancer, while the workers sleep), so the counter is simple.
+ * A blob can also own its content, as a list of chunks of at most
+ * BLOB_CHUNK_SIZE bytes (a rope), so a big doc doesn't need a big
+ * contiguous block. Every chunk is compressed separately (see
+ * blob_pack()).
+*******************************/
+typedef struct blob_t {
+	/* The number of references. */
+	u_int refs;
+	/* The content. It points in the input, which is kept until the
+	end, so the content isn't copied (NULL -> the content is kept
+	in chunks). */
+	const char *data;
+	/* The chunks of the content owned by the blob. */
+	blob_chunk_t *chunks;
+	/* The length of the content (0 -> not known yet, for a content
+	from the input). */
+	u_int size;
+	/* The number of bytes of the compressed chunks (0 -> the
+	content isn't compressed). */
+	u_int packed_size;
+} blob_t;
+
+/******************************
+ * blob_wrap() - Create a blob for a content from the input, without
+ *		to copy it.
+ *
+ * @param data: The content (it must live until the end).
+ *
+ * @return - The blob, with a reference.
+*******************************/
+blob_t *blob_wrap(const char *data);
+
+/******************************
+ * blob_pack() - Create a blob with the compressed content of another.
+ *
+ * @param blob: The blob which is compressed (it isn't modified).
+ *
+ * @return - The compressed blob, with a reference, or NULL if the content
+ *		is short, is already compressed or doesn't become smaller.
+*******************************/
+blob_t *blob_pack(blob_t *blob);
+
+/******************************
+ * blob_unpack() - Create a blob with the decompressed content of
+ *		a compressed one (in chunks, like the compressed one).
+ *
+ * @param blob: The compressed blob (it isn't modified).
+ *
+ * @return - The decompressed blob, with a reference.
+*******************************/
+blob_t *blob_unpack(blob_t *blob);
+
+/******************************
+ * @brief Find the length of the content of a blob (the length of
+ *		a content from the input is found just once).
+*******************************/
+u_int blob_size(blob_t *blob);
+
+/******************************
+ * blob_output() - Write the content of a blob, which isn't compressed,
+ *		in the response which is written (see output_response_part()).
+ *		The chunks are written one after the other, without to be put
+ *		together.
+ *
+ * @param blob: The blob.
+*******************************/
+void blob_output(blob_t *blob);
+
+/******************************
+ * @brief Take a reference to a blob and return the blob.
+*******************************/
+blob_t *blob_get(blob_t *blob);
+
+/******************************
+ * @brief Give back a reference to a blob. The last one frees the
+ *		blob. (NULL is ignored.)
+*******************************/
+void blob_put(blob_t *blob);
+
+#endif
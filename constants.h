@@ -4,15 +4,20 @@
 
 #define REQUEST_TYPE_LENGTH     64
 #define DOC_NAME_LENGTH         64
-#define DOC_CONTENT_LENGTH      4096
-#define REQUEST_LENGTH          (REQUEST_TYPE_LENGTH + DOC_NAME_LENGTH \
-                                 + DOC_CONTENT_LENGTH)
 
 #define EDIT_REQUEST            "EDIT"
 #define GET_REQUEST             "GET"
 #define ADD_SERVER_REQUEST      "ADD_SERVER"
 #define REMOVE_SERVER_REQUEST   "REMOVE_SERVER"
 
+#define ENABLE_VNODES_OPTION    "ENABLE_VNODES"
+#define BINARY_OUTPUT_OPTION    "--binary-output"
+#define CONVERT_OPTION          "--convert"
+#define THREADS_OPTION          "--threads"
+#define TARGETED_FLUSH_OPTION   "--targeted-flush"
+#define HASH_OPTION             "--hash"
+#define COMPRESS_OPTION         "--compress"
+
 #define GENERIC_MSG     "[Server %d]-Response: %s\n[Server %d]-Log: %s\n\n"
 
 #define MSG_A           "Request- %s %s - has been added to queue"
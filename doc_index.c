@@ -0,0 +1,160 @@
+// Copyright Necula Mihail 313CAa 2023-2024
+#include "doc_index.h"
+
+// Split a treap in 2 treaps: the docs with a hash smaller than the given
+// one (left) and the others docs (right).
+static void split_less(doc_t *t, u_int hash, doc_t **left, doc_t **right)
+{
+	if (!t) {
+		*left = NULL;
+		*right = NULL;
+		return;
+	}
+
+	if (t->hash < hash) {
+		split_less(t->idx_right, hash, &t->idx_right, right);
+		*left = t;
+	} else {
+		split_less(t->idx_left, hash, left, &t->idx_left);
+		*right = t;
+	}
+}
+
+// Split a treap in 2 treaps: the docs with a hash smaller or equal with
+// the given one (left) and the others docs (right).
+static void split_less_equal(doc_t *t, u_int hash, doc_t **left,
+							 doc_t **right)
+{
+	if (!t) {
+		*left = NULL;
+		*right = NULL;
+		return;
+	}
+
+	if (t->hash <= hash) {
+		split_less_equal(t->idx_right, hash, &t->idx_right, right);
+		*left = t;
+	} else {
+		split_less_equal(t->idx_left, hash, left, &t->idx_left);
+		*right = t;
+	}
+}
+
+// Merge 2 treaps. (Every hash from the left treap is smaller or
+// equal with every hash from the right treap.)
+static doc_t *merge(doc_t *left, doc_t *right)
+{
+	if (!left)
+		return right;
+	if (!right)
+		return left;
+
+	if (left->idx_priority > right->idx_priority) {
+		left->idx_right = merge(left->idx_right, right);
+		return left;
+	}
+	right->idx_left = merge(left, right->idx_left);
+	return right;
+}
+
+// Take out a doc from a treap in which all the docs have the same hash.
+static doc_t *erase(doc_t *t, doc_t *file)
+{
+	if (!t)
+		return NULL;
+	if (t == file)
+		return merge(t->idx_left, t->idx_right);
+
+	t->idx_left = erase(t->idx_left, file);
+	t->idx_right = erase(t->idx_right, file);
+	return t;
+}
+
+// Transform a treap in a list linked with idx_right (in the order of the
+// hashes) and put after it the given list. Return the number of docs
+// from the treap via count.
+static doc_t *flatten(doc_t *t, doc_t *list, u_int *count)
+{
+	if (!t)
+		return list;
+
+	t->idx_right = flatten(t->idx_right, list, count);
+	doc_t *left = t->idx_left;
+	t->idx_left = NULL;
+	(*count)++;
+
+	return flatten(left, t, count);
+}
+
+doc_index_t *doc_index_create(void)
+{
+	// Allocate memory for the index's structure.
+	doc_index_t *idx = (doc_index_t *)malloc(sizeof(doc_index_t));
+	DIE(idx == NULL, "malloc() failed\n");
+
+	// Initialize the fields of the index.
+	idx->root = NULL;
+	idx->size = 0;
+
+	// Return the created index.
+	return idx;
+}
+
+void doc_index_insert(doc_index_t *idx, doc_t *file)
+{
+	// The doc is a treap with a single node.
+	file->idx_left = NULL;
+	file->idx_right = NULL;
+
+	// Put the doc between the smaller and the greater hashes.
+	doc_t *left, *right;
+	split_less(idx->root, file->hash, &left, &right);
+	idx->root = merge(merge(left, file), right);
+
+	idx->size++;
+}
+
+void doc_index_remove(doc_index_t *idx, doc_t *file)
+{
+	// Isolate the docs which have the same hash as the given one.
+	doc_t *left, *middle, *right;
+	split_less(idx->root, file->hash, &left, &middle);
+	split_less_equal(middle, file->hash, &middle, &right);
+
+	// Take out the doc and put back the treap.
+	middle = erase(middle, file);
+	idx->root = merge(merge(left, middle), right);
+
+	idx->size--;
+}
+
+doc_t *doc_index_extract(doc_index_t *idx, u_int hash_lo, u_int hash_hi)
+{
+	doc_t *left, *middle, *right, *arc;
+
+	if (hash_lo < hash_hi) {
+		// The arc is [hash_lo, hash_hi).
+		split_less(idx->root, hash_lo, &left, &middle);
+		split_less(middle, hash_hi, &arc, &right);
+		idx->root = merge(left, right);
+	} else {
+		// The arc is [hash_lo, UINT_MAX] U [0, hash_hi).
+		split_less(idx->root, hash_hi, &left, &middle);
+		split_less(middle, hash_lo, &middle, &right);
+		idx->root = middle;
+		arc = merge(left, right);
+	}
+
+	// Make a list with the docs from the arc.
+	u_int count = 0;
+	doc_t *list = flatten(arc, NULL, &count);
+	idx->size -= count;
+
+	return list;
+}
+
+void doc_index_free(doc_index_t **idx)
+{
+	free(*idx);
+	*idx = NULL;
+}
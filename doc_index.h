@@ -0,0 +1,63 @@
+// Copyright Necula Mihail 313CAa 2023-2024
+#ifndef DOC_INDEX_H
+#define DOC_INDEX_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "lru_cache.h"
+#include "utils.h"
+
+/******************************
+ * The index keeps the documents of a server sorted after their
+ * position on the hash ring (the hash of their name). It's a treap
+ * whose links are stored in the documents, so an arc of the ring
+ * can be taken out without to go through the others documents.
+*******************************/
+typedef struct doc_index_t {
+	/* The root of the treap. */
+	doc_t *root;
+	/* The number of documents from index. */
+	u_int size;
+} doc_index_t;
+
+/******************************
+ * @return - A new empty index.
+*******************************/
+doc_index_t *doc_index_create(void);
+
+/******************************
+ * doc_index_insert() - Add a document in an index.
+ *
+ * @param idx: The index with which we work.
+ * @param file: The document (its hash must be set).
+*******************************/
+void doc_index_insert(doc_index_t *idx, doc_t *file);
+
+/******************************
+ * doc_index_remove() - Take out a document from an index.
+ *
+ * @param idx: The index with which we work.
+ * @param file: The document (it must be in the index).
+*******************************/
+void doc_index_remove(doc_index_t *idx, doc_t *file);
+
+/******************************
+ * doc_index_extract() - Take out from an index all the documents
+ *		whose hashes are from an arc of the ring.
+ *
+ * @param idx: The index with which we work.
+ * @param hash_lo: The start of the arc (included).
+ * @param hash_hi: The end of the arc (excluded). If hash_hi <= hash_lo,
+ *		the arc passes through 0. (hash_lo == hash_hi -> the whole ring)
+ *
+ * @return - The documents, sorted after their hashes, in a list
+ *		linked using the field idx_right.
+*******************************/
+doc_t *doc_index_extract(doc_index_t *idx, u_int hash_lo, u_int hash_hi);
+
+/******************************
+ * @brief Free the memory of an index. The documents aren't freed.
+*******************************/
+void doc_index_free(doc_index_t **idx);
+
+#endif
@@ -0,0 +1,39 @@
+// Copyright Necula Mihail 313CAa 2023-2024
+#include "driver.h"
+
+void apply_request(load_balancer_t *main, worker_pool_t *pool,
+				   parsed_request_t *req)
+{
+	// The servers are modified only while the workers sleep.
+	if (pool && (req->type == ADD_SERVER || req->type == REMOVE_SERVER))
+		worker_pool_wait(pool);
+
+	if (req->type == ADD_SERVER) {
+		DIE(req->cache_size < 0, "cache size must be positive");
+		DIE(req->weight <= 0, "server weight must be positive");
+		loader_add_server_weighted(main, req->server_id,
+								   (u_int)req->cache_size, (u_int)req->weight);
+		return;
+	}
+
+	if (req->type == REMOVE_SERVER) {
+		loader_remove_server(main, req->server_id);
+		return;
+	}
+
+	// Every name is stored and hashed once.
+	request_t server_request = {
+		.type = req->type,
+		.doc_name = names_intern(main->names, req->doc_name, req->doc_id),
+		.doc_content = req->doc_content,
+	};
+
+	if (pool) {
+		worker_pool_dispatch(pool, loader_route_request(main, &server_request),
+							 &server_request);
+		return;
+	}
+
+	response_t *response = loader_forward_request(main, &server_request);
+	PRINT_RESPONSE(response);
+}
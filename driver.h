@@ -0,0 +1,22 @@
+// Copyright Necula Mihail 313CAa 2023-2024
+#ifndef DRIVER_H
+#define DRIVER_H
+
+#include "load_balancer.h"
+#include "parser.h"
+#include "worker.h"
+
+/******************************
+ * apply_request() - Do a request which was read (or made up, see
+ *		bench.c): change the servers of the load balancer or send the
+ *		request to its server and write the response.
+ *
+ * @param main: The load balancer with which we work.
+ * @param pool: The workers which do the requests of the servers (NULL ->
+ *		the requests are done by the current thread).
+ * @param req: The request (its strings must live until the end).
+*******************************/
+void apply_request(load_balancer_t *main, worker_pool_t *pool,
+				   parsed_request_t *req);
+
+#endif
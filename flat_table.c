@@ -0,0 +1,261 @@
+// Copyright Necula Mihail 313CAa 2023-2024
+#include "flat_table.h"
+
+// Find the entry where a key should be. The hash is mixed, because
+// the hashes of the names aren't uniform in their last bits.
+static u_int flat_table_home(u_int hash, u_int shift)
+{
+	return (u_int)((hash * 2654435769u) >> shift);
+}
+
+// Allocate the entries of a table with the given size.
+static void flat_table_alloc(flat_table_t *t, u_int max_size)
+{
+	t->entries = (flat_entry_t *)calloc(max_size, sizeof(flat_entry_t));
+	DIE(t->entries == NULL, "calloc() failed\n");
+	t->max_size = max_size;
+
+	t->shift = 32;
+	for (u_int size = max_size; size > 1; size /= 2)
+		--t->shift;
+}
+
+// Search a key in an array of entries.
+static flat_entry_t *flat_table_probe(flat_table_t *t, flat_entry_t *entries,
+									  u_int max_size, u_int shift,
+									  const void *key, u_int hash)
+{
+	u_int mask = max_size - 1;
+	u_int pos = flat_table_home(hash, shift);
+
+	// Stop at an empty entry or at a key which is closer to its place
+	// than the searched key would be.
+	for (u_int dist = 1; entries[pos].dist >= dist; ++dist) {
+		flat_entry_t *entry = &entries[pos];
+		if (entry->hash == hash && (entry->key == key ||
+			(t->compare && !t->compare(entry->key, key))))
+			return entry;
+		pos = (pos + 1) & mask;
+	}
+
+	return NULL;
+}
+
+// Empty an entry of an array and move back the next keys which aren't
+// in their places, so there aren't holes between a key and its place.
+static void flat_table_erase(flat_entry_t *entries, u_int max_size,
+							 u_int pos)
+{
+	u_int mask = max_size - 1;
+	u_int next = (pos + 1) & mask;
+
+	while (entries[next].dist > 1) {
+		entries[pos] = entries[next];
+		entries[pos].dist--;
+		pos = next;
+		next = (next + 1) & mask;
+	}
+	entries[pos].dist = 0;
+}
+
+// Put a key which isn't in table in the first free entry of the new
+// array, moving forward the keys which are closer to their places.
+static void flat_table_insert(flat_table_t *t, flat_entry_t entry)
+{
+	u_int mask = t->max_size - 1;
+	u_int pos = flat_table_home(entry.hash, t->shift);
+	entry.dist = 1;
+
+	while (t->entries[pos].dist) {
+		// The key which is closer to its place gives its entry.
+		if (t->entries[pos].dist < entry.dist) {
+			flat_entry_t tmp = t->entries[pos];
+			t->entries[pos] = entry;
+			entry = tmp;
+		}
+		pos = (pos + 1) & mask;
+		entry.dist++;
+	}
+
+	t->entries[pos] = entry;
+}
+
+// Free the old array, if all its keys were moved.
+static void flat_table_drop_old(flat_table_t *t)
+{
+	if (t->old_entries && !t->old_size) {
+		free(t->old_entries);
+		t->old_entries = NULL;
+	}
+}
+
+// Move from the old array in the new one at least steps entries (full
+// or empty). A group of keys without empty entries between them is
+// moved entirely, so the keys which remain are still in a valid table.
+static void flat_table_migrate(flat_table_t *t, u_int steps)
+{
+	flat_entry_t *old = t->old_entries;
+	u_int mask = t->old_max_size - 1;
+	u_int pos = t->migrate_pos;
+
+	while (t->old_size && steps) {
+		// The cursor is on an empty entry; move the group after it.
+		pos = (pos + 1) & mask;
+		steps--;
+		while (old[pos].dist) {
+			flat_table_insert(t, old[pos]);
+			old[pos].dist = 0;
+			t->old_size--;
+			pos = (pos + 1) & mask;
+			if (steps)
+				steps--;
+		}
+	}
+
+	t->migrate_pos = pos;
+	flat_table_drop_old(t);
+}
+
+// Double the number of entries. The keys are moved later, a few by
+// every insertion or removal.
+static void flat_table_grow(flat_table_t *t)
+{
+	// The previous growth was finished long before (the new array has
+	// twice more entries), but verify it anyway.
+	if (t->old_entries)
+		flat_table_migrate(t, t->old_max_size + 1);
+
+	// The current array becomes the old one.
+	t->old_entries = t->entries;
+	t->old_max_size = t->max_size;
+	t->old_shift = t->shift;
+	t->old_size = t->size;
+	flat_table_alloc(t, 2 * t->old_max_size);
+
+	// Start the migration after an empty entry (the array is never full).
+	u_int pos = 0;
+	while (t->old_entries[pos].dist)
+		pos++;
+	t->migrate_pos = pos;
+}
+
+flat_table_t *flat_table_create(int (*compare)(const void *, const void *))
+{
+	// Allocate memory for the table's structure.
+	flat_table_t *t = (flat_table_t *)malloc(sizeof(flat_table_t));
+	DIE(t == NULL, "malloc() failed\n");
+	t->compare = compare;
+
+	// All the entries are empty.
+	flat_table_alloc(t, FLAT_TABLE_MIN_SIZE);
+	t->size = 0;
+
+	// The table didn't grow yet.
+	t->old_entries = NULL;
+	t->old_max_size = 0;
+	t->old_shift = 0;
+	t->old_size = 0;
+	t->migrate_pos = 0;
+
+	// Return the created table.
+	return t;
+}
+
+flat_entry_t *flat_table_find(flat_table_t *t, const void *key, u_int hash)
+{
+	// Search in the new array.
+	flat_entry_t *entry = flat_table_probe(t, t->entries, t->max_size,
+										   t->shift, key, hash);
+
+	// Search in the old array, if the key wasn't moved yet.
+	if (!entry && t->old_entries)
+		entry = flat_table_probe(t, t->old_entries, t->old_max_size,
+								 t->old_shift, key, hash);
+
+	return entry;
+}
+
+bool flat_table_put(flat_table_t *t, const void *key, u_int hash,
+					void *value)
+{
+	// Continue the growth, if it's the case.
+	if (t->old_entries)
+		flat_table_migrate(t, FLAT_TABLE_MIGRATE_STEP);
+
+	// If the key is in table, just replace the pair.
+	flat_entry_t *entry = flat_table_find(t, key, hash);
+	if (entry) {
+		entry->key = key;
+		entry->value = value;
+		return true;
+	}
+
+	// Verify if the table must be doubled.
+	if ((t->size + 1) * 8 > t->max_size * FLAT_TABLE_MAX_LOAD)
+		flat_table_grow(t);
+
+	flat_entry_t new_entry = {hash, 0, key, value};
+	flat_table_insert(t, new_entry);
+	t->size++;
+	return false;
+}
+
+void *flat_table_remove(flat_table_t *t, const void *key, u_int hash)
+{
+	// Continue the growth, if it's the case.
+	if (t->old_entries)
+		flat_table_migrate(t, FLAT_TABLE_MIGRATE_STEP);
+
+	// Find the key in the new array.
+	flat_entry_t *entry = flat_table_probe(t, t->entries, t->max_size,
+										   t->shift, key, hash);
+	if (entry) {
+		void *value = entry->value;
+		flat_table_erase(t->entries, t->max_size,
+						 (u_int)(entry - t->entries));
+		t->size--;
+		return value;
+	}
+
+	// Find the key in the old array.
+	if (!t->old_entries)
+		return NULL;
+	entry = flat_table_probe(t, t->old_entries, t->old_max_size,
+							 t->old_shift, key, hash);
+	if (!entry)
+		return NULL;
+
+	// (The moved keys are before the cursor, after empty entries, so
+	// the keys which are moved back here weren't moved yet.)
+	void *value = entry->value;
+	flat_table_erase(t->old_entries, t->old_max_size,
+					 (u_int)(entry - t->old_entries));
+	t->size--;
+	t->old_size--;
+	flat_table_drop_old(t);
+
+	return value;
+}
+
+void flat_table_for_each(flat_table_t *t, void (*func)(void *))
+{
+	for (u_int i = 0; i < t->max_size; ++i)
+		if (t->entries[i].dist)
+			func(t->entries[i].value);
+
+	if (t->old_entries)
+		for (u_int i = 0; i < t->old_max_size; ++i)
+			if (t->old_entries[i].dist)
+				func(t->old_entries[i].value);
+}
+
+void flat_table_free(flat_table_t **t)
+{
+	if (!*t)
+		return;
+
+	free((*t)->entries);
+	free((*t)->old_entries);
+	free(*t);
+	*t = NULL;
+}
@@ -0,0 +1,133 @@
+// Copyright Necula Mihail 313CAa 2023-2024
+#ifndef FLAT_TABLE_H
+#define FLAT_TABLE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "utils.h"
+
+/* The initial number of entries (a power of 2). */
+#define FLAT_TABLE_MIN_SIZE		16
+/* The table is doubled when it's filled more than
+FLAT_TABLE_MAX_LOAD / 8 of entries. */
+#define FLAT_TABLE_MAX_LOAD		7
+/* The minimum number of entries moved from the old array to the new one
+by an insertion or a removal, while the table grows. */
+#define FLAT_TABLE_MIGRATE_STEP	16
+
+/******************************
+ * An entry of a flat table. The hash is kept in the entry, so a key
+ * is compared only when the hashes are equal.
+*******************************/
+typedef struct flat_entry_t {
+	/* The hash of the key. */
+	u_int hash;
+	/* The distance from the entry where the key should be + 1
+	(0 -> the entry is empty). */
+	u_int dist;
+	/* The key (it isn't copied - it belongs to the value). */
+	const void *key;
+	/* The value. */
+	void *value;
+} flat_entry_t;
+
+/******************************
+ * A hashtable with open addressing (Robin Hood): all the entries are
+ * in a single array whose size is a power of 2, so a search touches
+ * just one or two cache lines and an insertion doesn't allocate memory.
+ * A key which is farther from its place takes the entry of a key which
+ * is closer, so the keys stay close to their places.
+ *
+ * The table grows incrementally: the old array is kept next to the
+ * doubled one and every insertion or removal moves some of its keys,
+ * so no operation moves all the keys at once. Until the old array is
+ * empty, a key is searched in both arrays.
+*******************************/
+typedef struct flat_table_t {
+	/* The function which compares 2 keys (0 -> equal). If it's NULL,
+	the keys are equal only if they have the same address (interned
+	keys). */
+	int (*compare)(const void *, const void *);
+	/* The entries. */
+	flat_entry_t *entries;
+	/* The number of keys from table (from both arrays). */
+	u_int size;
+	/* The number of entries (a power of 2). */
+	u_int max_size;
+	/* 32 - log2(max_size): the position of a key is given by the first
+	bits of its mixed hash. */
+	u_int shift;
+	/* The array from before the last growth (NULL, if all its keys
+	were moved) and its parameters. */
+	flat_entry_t *old_entries;
+	u_int old_max_size;
+	u_int old_shift;
+	/* The number of keys which are still in the old array. */
+	u_int old_size;
+	/* An empty entry of the old array. The keys after it weren't moved. */
+	u_int migrate_pos;
+} flat_table_t;
+
+/******************************
+ * flat_table_create() - Create an empty flat table.
+ *
+ * @param compare: The function which compares 2 keys (0 -> equal) or
+ *		NULL, if the keys are compared after their addresses.
+ *
+ * @return - The created table.
+*******************************/
+flat_table_t *flat_table_create(int (*compare)(const void *, const void *));
+
+/******************************
+ * flat_table_find() - Search a key in a flat table.
+ *
+ * @param t: The table with which we work.
+ * @param key: The key.
+ * @param hash: The hash of the key.
+ *
+ * @return - The entry of the key (its value can be changed) or NULL,
+ *		if the key isn't in table.
+*******************************/
+flat_entry_t *flat_table_find(flat_table_t *t, const void *key, u_int hash);
+
+/******************************
+ * flat_table_put() - Add a pair in a flat table. If the key is already
+ *		there, its key and value are replaced.
+ *
+ * @param t: The table with which we work.
+ * @param key: The key (it must live while it's in table).
+ * @param hash: The hash of the key.
+ * @param value: The value.
+ *
+ * @return - true, if the key was already in table
+ *			 false, if it was added
+*******************************/
+bool flat_table_put(flat_table_t *t, const void *key, u_int hash,
+					void *value);
+
+/******************************
+ * flat_table_remove() - Take out a key from a flat table.
+ *
+ * @param t: The table with which we work.
+ * @param key: The key.
+ * @param hash: The hash of the key.
+ *
+ * @return - The value of the key or NULL, if the key wasn't in table.
+*******************************/
+void *flat_table_remove(flat_table_t *t, const void *key, u_int hash);
+
+/******************************
+ * flat_table_for_each() - Call a function for every value from a
+ *		flat table.
+ *
+ * @param t: The table with which we work.
+ * @param func: The function.
+*******************************/
+void flat_table_for_each(flat_table_t *t, void (*func)(void *));
+
+/******************************
+ * @brief Free the memory of a flat table (not of its keys and values).
+*******************************/
+void flat_table_free(flat_table_t **t);
+
+#endif
@@ -0,0 +1,256 @@
+// Copyright Necula Mihail 313CAa 2023-2024
+#include <math.h>
+#include <time.h>
+#include "parser.h"
+#include "load_balancer.h"
+#include "utils.h"
+
+/* The number of names made up when no input file is given. */
+#define BENCH_NAMES			200000
+/* How many times every name is hashed to measure the speed. */
+#define BENCH_ROUNDS		20
+/* The servers put on the ring to measure the distribution. */
+#define BENCH_SERVERS		10
+/* The virtual nodes tested (1 -> without virtual nodes). */
+#define BENCH_MAX_REPLICAS	100
+
+/******************************
+ * The names on which the hash functions are tested.
+*******************************/
+typedef struct bench_names_t {
+	/* The names (every name appears once). */
+	char **names;
+	/* The number of names. */
+	u_int size;
+	/* The number of bytes of all the names. */
+	size_t bytes;
+	/* The memory of the made up names (NULL, if they are from a file). */
+	char *buff;
+} bench_names_t;
+
+/* The sum of the hashes (so the compiler doesn't skip the hashing). */
+static volatile u_int bench_sink;
+
+// Compare 2 names (for qsort()).
+static int bench_cmp_names(const void *a, const void *b)
+{
+	return strcmp(*(char * const *)a, *(char * const *)b);
+}
+
+// Compare 2 hashes (for qsort()).
+static int bench_cmp_hashes(const void *a, const void *b)
+{
+	u_int x = *(const u_int *)a, y = *(const u_int *)b;
+
+	return (x > y) - (x < y);
+}
+
+// Compare 2 points of the ring after their hashes (for qsort()).
+static int bench_cmp_points(const void *a, const void *b)
+{
+	return bench_cmp_hashes(&((const ring_point_t *)a)->hash_id,
+							&((const ring_point_t *)b)->hash_id);
+}
+
+// Take the names of the docs from an input file. Every name is kept once.
+static void bench_read_names(bench_names_t *bn, parser_t *p)
+{
+	int requests_num;
+	u_int replicas;
+	parsed_request_t req;
+
+	parser_read_header(p, &requests_num, &replicas);
+	bn->names = (char **)malloc((requests_num + 1) * sizeof(char *));
+	DIE(bn->names == NULL, "malloc() failed\n");
+	bn->size = 0;
+	bn->buff = NULL;
+
+	// The names point in the input.
+	for (int i = 0; i < requests_num; ++i) {
+		parser_next_request(p, &req);
+		if (req.type == EDIT_DOCUMENT || req.type == GET_DOCUMENT)
+			bn->names[bn->size++] = req.doc_name;
+	}
+
+	// Eliminate the duplicates.
+	qsort(bn->names, bn->size, sizeof(char *), bench_cmp_names);
+	u_int size = 0;
+	for (u_int i = 0; i < bn->size; ++i)
+		if (!size || strcmp(bn->names[size - 1], bn->names[i]))
+			bn->names[size++] = bn->names[i];
+	bn->size = size;
+}
+
+// Make up names which look like the ones from the tests
+// (a short prefix and a number).
+static void bench_make_names(bench_names_t *bn)
+{
+	bn->names = (char **)malloc(BENCH_NAMES * sizeof(char *));
+	DIE(bn->names == NULL, "malloc() failed\n");
+	bn->buff = (char *)malloc(BENCH_NAMES * DOC_NAME_LENGTH);
+	DIE(bn->buff == NULL, "malloc() failed\n");
+	bn->size = BENCH_NAMES;
+
+	for (u_int i = 0; i < BENCH_NAMES; ++i) {
+		bn->names[i] = bn->buff + i * DOC_NAME_LENGTH;
+		snprintf(bn->names[i], DOC_NAME_LENGTH, "%s_%u.txt",
+				 i % 2 ? "document" : "file", i);
+	}
+}
+
+// Measure how many names are hashed in a second.
+static void bench_speed(const hash_family_t *f, bench_names_t *bn)
+{
+	struct timespec start, end;
+	u_int sink = 0;
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (u_int r = 0; r < BENCH_ROUNDS; ++r)
+		for (u_int i = 0; i < bn->size; ++i)
+			sink += f->hash_docs(bn->names[i]);
+	clock_gettime(CLOCK_MONOTONIC, &end);
+
+	double sec = (end.tv_sec - start.tv_sec) +
+				 (end.tv_nsec - start.tv_nsec) / 1e9;
+	double hashes = (double)bn->size * BENCH_ROUNDS;
+	bench_sink = sink;
+	printf("  speed: %.1f ns/name, %.0f MB/s\n", sec * 1e9 / hashes,
+		   bn->bytes * (double)BENCH_ROUNDS / sec / 1e6);
+}
+
+// Put the names in 2^bits buckets, chosen with the given function, and
+// print the chi-squared of the counts, divided by its expected value
+// (about 1 for a good hash; more -> the buckets are uneven).
+static void bench_buckets(const char *what, u_int *hashes, u_int n,
+						  u_int bits, bool high_bits)
+{
+	u_int buckets = 1u << bits;
+	u_int *count = (u_int *)calloc(buckets, sizeof(u_int));
+	DIE(count == NULL, "calloc() failed\n");
+
+	// The flat table takes the first bits of the mixed hash, while a
+	// table with a modulo takes the last bits of the hash.
+	for (u_int i = 0; i < n; ++i) {
+		u_int pos = high_bits ? (hashes[i] * 2654435769u) >> (32 - bits)
+							  : hashes[i] & (buckets - 1);
+		count[pos]++;
+	}
+
+	double expected = (double)n / buckets, chi = 0;
+	u_int max = 0;
+	for (u_int i = 0; i < buckets; ++i) {
+		chi += (count[i] - expected) * (count[i] - expected) / expected;
+		if (count[i] > max)
+			max = count[i];
+	}
+	printf("  %s: chi2/dof %.3f, fullest bucket %u (mean %.2f)\n", what,
+		   chi / (buckets - 1), max, expected);
+
+	free(count);
+}
+
+// Put BENCH_SERVERS servers on the ring and print how uneven is the
+// number of docs which every server receives.
+static void bench_ring(const hash_family_t *f, u_int *hashes, u_int n,
+					   u_int replicas)
+{
+	u_int points_num = BENCH_SERVERS * replicas;
+	ring_point_t *ring = (ring_point_t *)malloc(points_num *
+												sizeof(ring_point_t));
+	DIE(ring == NULL, "malloc() failed\n");
+	u_int docs[BENCH_SERVERS] = {0};
+
+	// The points of the servers (like the load balancer puts them).
+	for (u_int s = 0; s < BENCH_SERVERS; ++s)
+		for (u_int r = 0; r < replicas; ++r) {
+			ring[s * replicas + r].hash_id = hash_replica(f->hash_servers,
+														  s, r);
+			ring[s * replicas + r].id = s;
+			ring[s * replicas + r].replica_idx = r;
+		}
+	qsort(ring, points_num, sizeof(ring_point_t), bench_cmp_points);
+
+	// Every doc goes to the first point with a greater hash.
+	for (u_int i = 0; i < n; ++i) {
+		u_int left = 0, right = points_num;
+		while (left < right) {
+			u_int mid = left + (right - left) / 2;
+			if (ring[mid].hash_id > hashes[i])
+				right = mid;
+			else
+				left = mid + 1;
+		}
+		docs[ring[left == points_num ? 0 : left].id]++;
+	}
+
+	double mean = (double)n / BENCH_SERVERS, var = 0;
+	u_int max = 0;
+	for (u_int s = 0; s < BENCH_SERVERS; ++s) {
+		var += (docs[s] - mean) * (docs[s] - mean) / BENCH_SERVERS;
+		if (docs[s] > max)
+			max = docs[s];
+	}
+	printf("  ring (%u servers x %u points): max/mean %.2f, cv %.3f\n",
+		   BENCH_SERVERS, replicas, max / mean, sqrt(var) / mean);
+
+	free(ring);
+}
+
+int main(int argc, char **argv)
+{
+	bench_names_t bn;
+	parser_t *p = NULL;
+
+	// Take the names from the given input file or make them up.
+	if (argc > 1) {
+		p = parser_open(argv[1]);
+		bench_read_names(&bn, p);
+	} else {
+		bench_make_names(&bn);
+	}
+	bn.bytes = 0;
+	for (u_int i = 0; i < bn.size; ++i)
+		bn.bytes += strlen(bn.names[i]);
+	DIE(bn.size < 2, "too few names\n");
+	printf("%u names, %.1f bytes/name\n\n", bn.size,
+		   (double)bn.bytes / bn.size);
+
+	// The number of buckets is about the number of names.
+	u_int bits = 1;
+	while ((1u << (bits + 1)) <= bn.size)
+		bits++;
+
+	u_int *hashes = (u_int *)malloc(bn.size * sizeof(u_int));
+	DIE(hashes == NULL, "malloc() failed\n");
+
+	// Test every family of hash functions.
+	for (const hash_family_t *f = hash_families; f->name; ++f) {
+		printf("%s\n", f->name);
+		bench_speed(f, &bn);
+
+		for (u_int i = 0; i < bn.size; ++i)
+			hashes[i] = f->hash_docs(bn.names[i]);
+		bench_buckets("low bits ", hashes, bn.size, bits, false);
+		bench_buckets("flat table", hashes, bn.size, bits, true);
+
+		// The distinct hashes (collisions make the docs share a place).
+		qsort(hashes, bn.size, sizeof(u_int), bench_cmp_hashes);
+		u_int collisions = 0;
+		for (u_int i = 1; i < bn.size; ++i)
+			collisions += hashes[i] == hashes[i - 1];
+		printf("  collisions: %u\n", collisions);
+
+		for (u_int r = 1; r <= BENCH_MAX_REPLICAS; r *= 10)
+			bench_ring(f, hashes, bn.size, r);
+		printf("\n");
+	}
+
+	// Free the memory.
+	free(hashes);
+	free(bn.names);
+	free(bn.buff);
+	if (p)
+		parser_close(&p);
+
+	return 0;
+}
@@ -3,22 +3,30 @@
 #include "load_balancer.h"
 #include "server.h"
 
-load_balancer_t *init_load_balancer(bool enable_vnodes)
+load_balancer_t *init_load_balancer(u_int replicas,
+									const hash_family_t *hash)
 {
+	// The number of replicas is read from the input.
+	DIE(replicas > MAX_REPLICAS, "too many replicas for a server");
+
 	// Allocate memory for the load balancer's structure.
 	load_balancer_t *main = (load_balancer_t *)malloc(sizeof(load_balancer_t));
 	DIE(main == NULL, "malloc() failed\n");
 
 	// Allocate memory for every complex field from structure.
-	main->server = (server_t **)malloc(sizeof(server_t *));
-	DIE(main->server == NULL, "malloc() failed\n");
+	main->ring = (ring_point_t *)malloc(sizeof(ring_point_t));
+	DIE(main->ring == NULL, "malloc() failed\n");
 
 	// Initialize the parameters of the load balancer.
 	main->size = 0;
 	main->max_size = 1;
-	main->replicas = (enable_vnodes == false) ? 1 : 3;
-	main->hash_function_servers = hash_uint;
-	main->hash_function_docs = hash_string;
+	main->replicas = replicas ? replicas : 1;
+	main->targeted_flush = false;
+	main->compress = false;
+	memset(&main->stats, 0, sizeof(main->stats));
+	main->hash_function_servers = hash->hash_servers;
+	main->hash_function_docs = hash->hash_docs;
+	main->names = names_create(hash->hash_docs);
 
 	// Return the created load balancer.
 	return main;
@@ -28,149 +36,148 @@ load_balancer_t *init_load_balancer(bool enable_vnodes)
 void load_balancer_double_servers(load_balancer_t *main)
 {
 	main->max_size *= 2;
-	main->server = (server_t **)realloc(main->server,
-					main->max_size * sizeof(server_t *));
-	DIE(main->server == NULL, "malloc() failed\n");
+	main->ring = (ring_point_t *)realloc(main->ring,
+					main->max_size * sizeof(ring_point_t));
+	DIE(main->ring == NULL, "realloc() failed\n");
+}
+
+u_int lb_find_server(load_balancer_t *main, u_int hash)
+{
+	// Search the first point with a hash greater than the given one.
+	u_int left = 0, right = main->size;
+	while (left < right) {
+		u_int mid = left + (right - left) / 2;
+		if (main->ring[mid].hash_id > hash)
+			right = mid;
+		else
+			left = mid + 1;
+	}
+
+	// If there isn't such a point, the ring is closed by the first one.
+	return (left == main->size) ? 0 : left;
+}
+
+// Verify if a point is placed before the triple (hash_id, id,
+// replica_idx) in ring.
+static bool lb_point_before(ring_point_t *point, u_int hash_id, u_int id,
+							u_int replica_idx)
+{
+	if (point->hash_id != hash_id)
+		return point->hash_id < hash_id;
+	if (point->id != id)
+		return point->id < id;
+	return point->replica_idx < replica_idx;
 }
 
-void combine_databases(server_t *dst, server_t *src)
+// Find the position of the first point which isn't placed before
+// the triple (hash_id, id, replica_idx) in ring.
+static u_int lb_lower_bound(load_balancer_t *main, u_int hash_id, u_int id,
+							u_int replica_idx)
 {
-	for (u_int i = 0; i < (*src->local_db)->hmax; ++i) {
-		ll_t *curr_list = (ll_t *)(*src->local_db)->buckets[i];
-		ll_node_t *curr_node = curr_list->head;
-
-		while(curr_node) {
-			info_t *pair = (info_t *)curr_node->data;
-			doc_t *file = *(doc_t **)pair->value;
-			doc_t *file_dup = init_doc(file->name, file->content);
-			db_add_doc(dst, file_dup);
-			curr_node = curr_node->next;
-		}
+	u_int left = 0, right = main->size;
+	while (left < right) {
+		u_int mid = left + (right - left) / 2;
+		if (lb_point_before(&main->ring[mid], hash_id, id, replica_idx))
+			left = mid + 1;
+		else
+			right = mid;
 	}
+
+	return left;
+}
+
+u_int lb_find_replica(load_balancer_t *main, u_int server_id,
+					  u_int replica_idx)
+{
+	// The point of a replica is placed after the hash of the pair
+	// (server_id, replica_idx).
+	u_int hash_id = hash_replica(main->hash_function_servers, server_id,
+								 replica_idx);
+	u_int pos = lb_lower_bound(main, hash_id, server_id, replica_idx);
+
+	// Verify if the replica was found.
+	if (pos == main->size || main->ring[pos].id != server_id ||
+		main->ring[pos].replica_idx != replica_idx)
+		return main->size;
+	return pos;
 }
 
 u_int lb_add_server_in_array(load_balancer_t *main, server_t *new_s)
 {
 	// Find the position where should be put the server in
-	// the array of servers.
-	u_int pos = main->size;
-	for (u_int i = 0; i < main->size; ++i) {
-		if (main->server[i]->hash_id > new_s->hash_id) {
-			pos = i;
-			break;
-		}
-		if (main->server[i]->hash_id ==  new_s->hash_id) {
-			if (main->server[i]->id > new_s->id) {
-				pos = i;
-				break;
-			}
-		}
-	}
+	// the ring. (After all the points with a smaller hash or with
+	// the same hash and a smaller / equal id and replica.)
+	u_int pos = lb_lower_bound(main, new_s->hash_id, new_s->id,
+							   new_s->replica_idx);
+	while (pos < main->size && main->ring[pos].hash_id == new_s->hash_id
+		   && main->ring[pos].id == new_s->id
+		   && main->ring[pos].replica_idx == new_s->replica_idx)
+		++pos;
 
 	// Shifts all elements from the right to right with +1 position.
-	for (u_int i = main->size; i > pos; --i)
-		main->server[i] = main->server[i - 1];
+	memmove(&main->ring[pos + 1], &main->ring[pos],
+			(main->size - pos) * sizeof(ring_point_t));
 
-	// Now, we can put the server in array.
-	main->server[pos] = new_s;
+	// Now, we can put the server in ring.
+	main->ring[pos].hash_id = new_s->hash_id;
+	main->ring[pos].id = new_s->id;
+	main->ring[pos].replica_idx = new_s->replica_idx;
+	main->ring[pos].srv = new_s;
 
 	// Increment the numbers of servers.
 	main->size++;
 
-	// Return the position of the new server in the array of servers.
+	// Return the position of the new server in the ring.
 	return pos;
 }
 
-server_t
-*loader_add_replica(load_balancer_t *main, u_int server_id, u_int cache_size)
+void loader_add_replica(load_balancer_t *main, server_t *rpl)
 {
-	// Verify if we must double the size of the array of servers.
+	// Verify if we must double the size of the ring.
 	if (main->size == main->max_size)
 		load_balancer_double_servers(main);
 
-	// Create the new server / the destination server.
-	server_t *dst_srv = init_server(server_id, cache_size);
-	dst_srv->hash_id = main->hash_function_servers(&server_id);
+	// Add the replica in the ring.
+	u_int pos_dst = lb_add_server_in_array(main, rpl);
+	server_t *dst_srv = rpl->mom;
 
-	// Add the new server in the array of servers.
-	u_int pos_dst = lb_add_server_in_array(main, dst_srv);
-
-	// Find the source server.
+	// Find the source server. (The server which was responsible
+	// for the docs from the arc taken by the new replica.)
 	u_int pos_src = (pos_dst + 1) % main->size;
-	server_t *src_srv = main->server[pos_src];
+	server_t *src_srv = main->ring[pos_src].srv;
+
+	// If the arc was already of the new server, there is nothing to move.
+	if (src_srv->mom == dst_srv)
+		return;
 
 	// Empty the task queue of the source server.
 	do_tasks_from_queue(src_srv);
 
-	// Verify every file from the source server if must be moved
-	// in the new server.
-
-	// Find the server from ring which is before the sorce server,
-	// witout to take in consideration the new server.
-	u_int pos_prev = (pos_src + main->size - 2) % main->size;
-	server_t *prev_srv = main->server[pos_prev];
-
-	for (u_int i = 0; i < (*src_srv->local_db)->hmax; ++i) {
-		ll_t *curr_list = (ll_t *)(*src_srv->local_db)->buckets[i];
-		ll_node_t * curr_node = curr_list->head;
-
-		while(curr_node) {
-			info_t *pair = (info_t *)curr_node->data;
-			char *doc_name = (char *)pair->key;
-			u_int hash_doc = main->hash_function_docs(doc_name);
-
-			// Verify if the current doc is bewtwen the source
-			// and the previous server. (We need to verify this for
-			// the load balancers which have more than 1 replica for a server.)
-			if (src_srv->hash_id > prev_srv->hash_id)
-				if (hash_doc > src_srv->hash_id || hash_doc <= prev_srv->hash_id) {
-					curr_node = curr_node->next;
-					continue;
-				}
-			if (src_srv->hash_id < prev_srv->hash_id)
-				if (hash_doc > src_srv->hash_id && hash_doc <= prev_srv->hash_id) {
-					curr_node = curr_node->next;
-					continue;
-				}
-
-			// Verify if the current doc must be moved.
-			u_int move = 0;
-			if (hash_doc < dst_srv->hash_id && dst_srv->hash_id < src_srv->hash_id)
-				move = 1;
-			if (hash_doc < dst_srv->hash_id && dst_srv->hash_id == src_srv->hash_id
-			&& dst_srv->id < src_srv->id)
-				move  = 1;
-			if (hash_doc > src_srv->hash_id && src_srv->hash_id > dst_srv->hash_id)
-				move = 1;
-			if (hash_doc > src_srv->hash_id && src_srv->hash_id == dst_srv->hash_id
-			&& src_srv->id > dst_srv->id)
-				move = 1;
-			if (hash_doc > src_srv->hash_id && hash_doc < dst_srv->hash_id)
-				move = 1;
-
-			if (move) {
-				doc_t *file = *(doc_t **)pair->value;
-				// Do a duplicate of the file.
-				doc_t *file_dup = init_doc(file->name, file->content);
-				// Remove the file from the database of source server.
-				curr_node = curr_node->next;
-				db_remove_doc(src_srv, file_dup->name);
-				// Remove it also from the cache if it's there.
-				if (lru_cache_has_key(src_srv->cache, file_dup->name))
-					lru_cache_remove(src_srv->cache, file_dup->name);
-				// Add the duplicate file in the destination server.
-				db_add_doc(dst_srv, file_dup);
-			} else {
-				curr_node = curr_node->next;
-			}
-		}
-	}
+	// The new replica is responsible for the docs with the hashes
+	// from [hash of the previous point, hash of the replica). If the
+	// previous point has the same hash, the arc is empty.
+	u_int pos_prev = (pos_dst + main->size - 1) % main->size;
+	u_int hash_lo = main->ring[pos_prev].hash_id;
+	if (pos_dst && hash_lo == rpl->hash_id)
+		return;
 
-	// Return the new server which was added.
-	return dst_srv;
+	// Take out just the docs from that arc. (The source server can
+	// have more replicas, so it can have docs from others arcs.)
+	doc_t *file = db_take_docs(src_srv, hash_lo, rpl->hash_id);
+
+	// Move every doc in the new server, without to copy it.
+	while (file) {
+		doc_t *next = file->idx_right;
+		// Add the file in the destination server. It isn't in cache,
+		// so it's cold.
+		db_add_doc(dst_srv, file);
+		server_compress_doc(dst_srv, file);
+		file = next;
+	}
 }
 
-server_t *create_replica_of_server(server_t *s, u_int id, u_int hash_id)
+server_t *create_replica_of_server(server_t *s, u_int replica_idx,
+								   u_int hash_id)
 {
 	// Allocate memory fo the replica.
 	server_t *replica = (server_t *)malloc(sizeof(server_t));
@@ -179,218 +186,182 @@ server_t *create_replica_of_server(server_t *s, u_int id, u_int hash_id)
 	// Add the resources of the servers in replica.
 	replica->cache = s->cache;
 	replica->local_db = s->local_db;
+	replica->doc_index = s->doc_index;
 	replica->task_queue = s->task_queue;
-
-	// Initialize the parameters of replica.
-	replica->id = id;
+	replica->pending_edits = s->pending_edits;
+	replica->mom = s->mom;
+	replica->worker = s->worker;
+	replica->targeted_flush = s->targeted_flush;
+	replica->compress = s->compress;
+
+	// Initialize the parameters of replica. It has the id of the mom
+	// server, so its responses are given in the name of the server.
+	replica->id = s->id;
+	replica->replica_idx = replica_idx;
 	replica->hash_id = hash_id;
 
 	return replica;
 }
 
-
 void loader_add_server(load_balancer_t *main, u_int server_id, u_int cache_size)
 {
-	// 1 replica for server
-	if(main->replicas == 1) {
-		loader_add_replica(main, server_id, cache_size);
-		return;
-	}
-
-	// 3 replicas for server
-
-	// Firstly, we add the 3 replicas in the system, independently.
-	// (rpl = replica)
-	server_t *rpl_1 = loader_add_replica(main, server_id, cache_size);
-	server_t *rpl_2 = loader_add_replica(main, 100000 + server_id, cache_size);
-	server_t *rpl_3 = loader_add_replica(main, 200000 + server_id, cache_size);
-
-	// After, we combine those replicas to have the resources put at common.
-
-	// Add the docs from the database of the second replica
-	// in the database of the first replica
-	combine_databases(rpl_1, rpl_2);
-
-	// Free the memory of the second replica's resources.
-	free_resources_of_server(rpl_2);
-
-	// Create the second replica how should be (at common with the first one).
-	u_int rpl_2_id = 100000 + server_id;
-	u_int hash_id = main->hash_function_servers(&rpl_2_id);
-	server_t *new_rpl_2 = create_replica_of_server(rpl_1, rpl_2_id, hash_id);
-
-	// Add the fields of the new replica in the old replica.
-	*rpl_2 = *new_rpl_2;
-	free(new_rpl_2);
-
-	// Add the docs from the database of the third replica
-	// in the database of the first and second replicas.
-	combine_databases(rpl_1, rpl_3);
-
-	// Free the memory of the third replica resource's.
-	free_resources_of_server(rpl_3);
-
-	// Create the third replica how should be (at common with the first one
-	// and the scond one).
-	u_int rpl_3_id = 200000 + server_id;
-	hash_id = main->hash_function_servers(&rpl_3_id);
-	server_t *new_rpl_3 = create_replica_of_server(rpl_1, rpl_3_id, hash_id);
-
-	// Add the fields of the new replica in the old replica.
-	*rpl_3 = *new_rpl_3;
-	free(new_rpl_3);
+	loader_add_server_weighted(main, server_id, cache_size, 1);
 }
 
-void loader_remove_replica(load_balancer_t *main, u_int server_id)
+void loader_add_server_weighted(load_balancer_t *main, u_int server_id,
+								u_int cache_size, u_int weight)
 {
-	// Find the position of the source server in the
-	// load balancer's array.
-	u_int src_pos;
-	for (u_int i  = 0; i < main->size; ++i) {
-		if (main->server[i]->id == server_id) {
-			src_pos = i;
-			break;
-		}
+	// The number of replicas must fit in an u_int and in memory.
+	if (!weight)
+		weight = 1;
+	DIE(weight > MAX_REPLICAS / main->replicas,
+		"too many replicas for a server");
+
+	// Create the server which owns the resources. It's also
+	// the first replica.
+	server_t *mom = init_server(server_id, cache_size);
+	mom->hash_id = hash_replica(main->hash_function_servers, server_id, 0);
+	mom->targeted_flush = main->targeted_flush;
+	mom->compress = main->compress;
+	loader_add_replica(main, mom);
+
+	// Add the others replicas, one by one, which have the
+	// resources at common with the first one. The share of ring
+	// of a server is proportional with its weight.
+	u_int replicas = main->replicas * weight;
+	for (u_int i = 1; i < replicas; ++i) {
+		u_int hash_id = hash_replica(main->hash_function_servers,
+									 server_id, i);
+		loader_add_replica(main, create_replica_of_server(mom, i, hash_id));
 	}
+}
 
-	// Find the source server.
-	server_t *src_srv = main->server[src_pos];
-
-	// Do every request from the tasks queue of source server.
-	do_tasks_from_queue(src_srv);
-
-	// Find the position of the destination server in the
-	// load balancer's array.
-	u_int dst_pos = (src_pos + 1) % main->size;
-
-	// Find the destination server.
-	server_t *dst_srv = main->server[dst_pos];
-
-	// Add every doc from source in destination.
-	combine_databases(dst_srv, src_srv);
-
-	// Free the memory allocated for the source server.
-	free_server(&main->server[src_pos]);
-
-	// Fill the gap from the load balancer's array
-	// made by the remove operation.
-	for (u_int i = src_pos; i < main->size - 1; ++i)
-		main->server[i] = main->server[i + 1];
+void lb_redistribute_docs(load_balancer_t *main, server_t *src)
+{
+	// Take out all the docs of the server, sorted after their hashes.
+	doc_t *file = db_take_docs(src, 0, 0);
 
-	// Decrement the number of server from the systme.
-	main->size--;
+	// Go through the docs and through the ring in the same time. The docs
+	// are sorted, so the point responsible for them only goes forward.
+	u_int pos = 0;
+	while (file) {
+		doc_t *next = file->idx_right;
+
+		// Find the server which is now responsible for the doc.
+		while (pos < main->size && main->ring[pos].hash_id <= file->hash)
+			++pos;
+		server_t *dst = main->ring[pos == main->size ? 0 : pos].srv;
+
+		// Move the doc in its database, without to copy it. It isn't
+		// in cache, so it's cold.
+		db_add_doc(dst, file);
+		server_compress_doc(dst, file);
+		file = next;
+	}
 }
 
 void loader_remove_server(load_balancer_t *main, u_int server_id)
 {
-	// 1 replica for server
-	if (main->replicas == 1) {
-		loader_remove_replica(main, server_id);
+	// Find the server (its first replica owns the resources).
+	u_int pos = lb_find_replica(main, server_id, 0);
+	if (pos == main->size)
 		return;
-	}
+	server_t *mom = main->ring[pos].srv;
 
-	// 3 replicas for server
-
-	// Find the replicas of the server.
-	// (rpl  = replica)
-	u_int mom_srv_id = server_id % 100000;
-	u_int pos_rpl_1, pos_rpl_2, pos_rpl_3;
-	server_t *rpl_1 = NULL, *rpl_2 = NULL, *rpl_3 = NULL;
-	for (u_int i  = 0; i  < main->size; ++i) {
-		if (main->server[i]->id == mom_srv_id) {
-			rpl_1 = main->server[i];
-			pos_rpl_1 = i;
-		}
-		if (main->server[i]->id == 100000 + mom_srv_id) {
-			rpl_2 = main->server[i];
-			pos_rpl_2 = i;
-		}
-		if (main->server[i]->id == 200000 + mom_srv_id) {
-			rpl_3 = main->server[i];
-			pos_rpl_3 = i;
-		}
-		if (rpl_1 && rpl_2 && rpl_3)
-			break;
-	}
+	// Do every request from the tasks queue of the server.
+	do_tasks_from_queue(mom);
 
-	// Create a tempoarry load balancer when we put those 3 replicas,
-	// independently (without to have the resources at common).
-	// In this system, every replica becomes a independent server.
-	load_balancer_t *lb_tmp = init_load_balancer(false);
-
-	// Add first replica.
-	lb_tmp->server[0] = rpl_1;
-	lb_tmp->size = 1;
-	// Add second replica.
-	loader_add_server(lb_tmp, rpl_2->id, 1);
-	free(rpl_2);
-	// Add third replica.
-	loader_add_server(lb_tmp, rpl_3->id, 1);
-	free(rpl_3);
-
-	// Change the replicas from the main load balancer
-	// with the servers from the temporary load balancer.
-	for (u_int i  = 0; i  < 3; ++i) {
-		if (lb_tmp->server[i]->id == mom_srv_id)
-			main->server[pos_rpl_1] = lb_tmp->server[i];
-		if (lb_tmp->server[i]->id == 100000 + mom_srv_id)
-			main->server[pos_rpl_2] = lb_tmp->server[i];
-		if (lb_tmp->server[i]->id == 200000 + mom_srv_id)
-			main->server[pos_rpl_3] = lb_tmp->server[i];
+	// Take out all the replicas of the server from the ring, in a
+	// single pass. The memory of the mom server is kept until its
+	// docs are moved.
+	u_int new_size = 0;
+	for (u_int i = 0; i < main->size; ++i) {
+		server_t *srv = main->ring[i].srv;
+		if (srv->mom != mom)
+			main->ring[new_size++] = main->ring[i];
+		else if (srv != mom)
+			free(srv);
 	}
+	main->size = new_size;
 
-	// Remove the servers which now have 1 replica and are
-	// coresponding to the replicas which we transformed.
-	loader_remove_replica(main, mom_srv_id);
-	loader_remove_replica(main, 100000 + mom_srv_id);
-	loader_remove_replica(main, 200000 + mom_srv_id);
+	// Move every doc in the server which is now responsible for it.
+	if (main->size)
+		lb_redistribute_docs(main, mom);
 
-	// Free the unnecesary memory.
-	free(lb_tmp->server);
-	free(lb_tmp);
+	// Keep the statistics and free the memory allocated for the server.
+	server_stats_add(&main->stats, &mom->stats);
+	free_server(&mom);
 }
 
-response_t *loader_forward_request(load_balancer_t *main, request_t *req)
+server_t *loader_route_request(load_balancer_t *main, request_t *req)
 {
-	// Find the hash of the dos's name.
-	u_int hash_doc = main->hash_function_docs(req->doc_name);
-
-	// Find the server to which the request must be sent.
-	u_int pos = 0;
-	for (u_int i = 0; i < main->size; ++i)
-		if (main->server[i]->hash_id > hash_doc) {
-			pos = i;
-			break;
-		}
+	// The hash of the dos's name was computed once, when the name was
+	// interned.
+	u_int pos = lb_find_server(main, req->doc_name->hash);
+	return main->ring[pos].srv;
+}
 
+response_t *loader_forward_request(load_balancer_t *main, request_t *req)
+{
 	// Send the request further.
-	server_t *srv = main->server[pos];
+	server_t *srv = loader_route_request(main, req);
 	response_t *rsp = server_handle_request(srv, req);
 
 	// Return the response of the request.
 	return rsp;
 }
 
+void loader_flush_servers(load_balancer_t *main)
+{
+	// Every server which owns resources (so a task queue) does the
+	// tasks left by its GETs, in the order of the ring.
+	for (u_int i = 0; i < main->size; ++i) {
+		server_t *srv = main->ring[i].srv;
+		if (srv->mom == srv)
+			do_tasks_from_queue_batch(srv, srv->unflushed_tasks);
+	}
+}
+
+void loader_print_stats(load_balancer_t *main, FILE *f)
+{
+	// Add the statistics of the servers from ring to the ones of the
+	// removed servers. (Every server which owns resources is counted
+	// once.)
+	server_stats_t stats = main->stats;
+	for (u_int i = 0; i < main->size; ++i)
+		if (main->ring[i].srv->mom == main->ring[i].srv)
+			server_stats_add(&stats, &main->ring[i].srv->stats);
+
+	double ratio = stats.packed_bytes ?
+				   (double)stats.raw_bytes / stats.packed_bytes : 0;
+	double unpack_ns = stats.unpacked_docs ?
+					   (double)stats.unpack_ns / stats.unpacked_docs : 0;
+	fprintf(f, "compression: %u docs packed, %llu -> %llu bytes (%.2fx)\n",
+			stats.packed_docs, (unsigned long long)stats.raw_bytes,
+			(unsigned long long)stats.packed_bytes, ratio);
+	fprintf(f, "compression: %u docs unpacked by GETs, %.0f ns per doc\n",
+			stats.unpacked_docs, unpack_ns);
+}
+
 void free_load_balancer(load_balancer_t **main)
 {
 	// Get the load_balancer's address.
 	load_balancer_t *lb = *main;
 
-	// Free the memory of every server.
-	u_int *visited = (u_int *)calloc(99999, sizeof(u_int));
-	DIE(visited == NULL, "calloc() failed\n");
+	// Free the memory of every server. The resources are freed just
+	// once, together with the server which owns them.
 	for (u_int i = 0; i < lb->size; ++i) {
-		u_int mom_srv_id = lb->server[i]->id % 100000;
-		if (!visited[mom_srv_id])
-			free_server(&lb->server[i]);
+		server_t *srv = lb->ring[i].srv;
+		if (srv->mom == srv)
+			free_server(&lb->ring[i].srv);
 		else
-			free(lb->server[i]);
-		visited[mom_srv_id] = 1;
+			free(srv);
 	}
-	free(visited);
 
-	// Free the array of server's memory.
-	free(lb->server);
+	// Free the memory of the ring and of the names. (The docs
+	// were freed.)
+	free(lb->ring);
+	names_free(&lb->names);
 
 	// Free the memory of the load balancer structure.
 	free(lb);
@@ -399,4 +370,3 @@ void free_load_balancer(load_balancer_t **main)
 	// doesn't exist anymore.
 	*main = NULL;
 }
-
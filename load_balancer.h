@@ -3,38 +3,75 @@
 #define LOAD_BALANCER_H
 
 #include "server.h"
-#include "hash_map.h"
+#include "names.h"
 
-#define MAX_SERVERS 99999
+/* The number of replicas of a server when the virtual
+nodes are enabled and their number isn't specified. */
+#define DEFAULT_REPLICAS	3
+/* The maximum number of replicas (points on the hash ring) of
+a server, with its weight. */
+#define MAX_REPLICAS		65536
+
+/******************************
+ * Structure to save a point from the hash ring. The points are
+ * kept in a compact array, separately from the servers, so a
+ * lookup touches only this array.
+*******************************/
+typedef struct ring_point_t {
+	/* The hash of the server's id / the position on the ring. */
+	u_int hash_id;
+	/* The id of the server and the index of the replica (used to
+	order the points with the same hash). */
+	u_int id;
+	u_int replica_idx;
+	/* The server which is placed in this point. */
+	server_t *srv;
+} ring_point_t;
 
 /******************************
  * Structure to save the informations of a load balancer.
 *******************************/
 typedef struct load_balancer_t {
-	/* Array of servers. */
-	server_t **server;
-	/* Number of servers. */
+	/* The hash ring: array of points sorted after (hash_id, id,
+	replica_idx). */
+	ring_point_t *ring;
+	/* Number of points from ring. */
 	u_int size;
-	/* Maximum number of servers which can be stored
+	/* Maximum number of points which can be stored
 	in load balancer. */
 	u_int max_size;
-	/* Nummber of raplicas for a server. */
-	int replicas;
+	/* Nummber of raplicas (virtual nodes) for a server. */
+	u_int replicas;
+	/* true -> the new servers use the targeted flush (see
+	server_handle_request()) */
+	bool targeted_flush;
+	/* true -> the new servers compress their cold docs (see
+	server_compress_doc()) */
+	bool compress;
+	/* The statistics of the compression of the servers which were
+	removed. */
+	server_stats_t stats;
 	/* Pointer to a function which hash the id of a server.*/
 	unsigned int (*hash_function_servers)(void *);
 	/* Pointer to a function which hash the name of a doc.*/
 	unsigned int (*hash_function_docs)(void *);
+	/* The names of the docs, interned (hashed with
+	hash_function_docs). */
+	name_table_t *names;
 } load_balancer_t;
 
 /******************************
  * init_load_balancer() - Create and initialize a load balancer.
  *
- * @param enalbe_vnode: true  -> every server has 3 replicas
- *                      false -> every server has 1 replica
+ * @param replicas: The number of replicas (points on the hash ring)
+ *      which every server has. (1 -> the virtual nodes are disabled;
+ *      at most MAX_REPLICAS)
+ * @param hash: The hash functions of the servers and of the docs.
  *
  * @return - The created load balancer.
 *******************************/
-load_balancer_t *init_load_balancer(bool enable_vnodes);
+load_balancer_t *init_load_balancer(u_int replicas,
+									const hash_family_t *hash);
 
 /******************************
  * @brief Double the number of servers which can be stored in
@@ -43,57 +80,70 @@ load_balancer_t *init_load_balancer(bool enable_vnodes);
 void load_balancer_double_servers(load_balancer_t *main);
 
 /******************************
- *	combine_databases() - Add the docs from the source server
- *		in the destination server. The files are added just in
- *		the databse, not and in the cache. The files from
- *		the source server are not removed.
+ * lb_find_server() - Find, using a binary search, the point from the
+ *      ring which is responsible for the given hash. (The first point
+ *      with a greater hash or, if doesn't exist, the first point.)
+ *
+ * @param main: The load balancer with which we work.
+ * @param hash: The hash of a document's name.
+ *
+ * @return - The position of the point in the ring.
+*******************************/
+u_int lb_find_server(load_balancer_t *main, u_int hash);
+
+/******************************
+ * lb_find_replica() - Find, using a binary search, the position of a
+ *      replica of a server in the ring.
+ *
+ * @param main: The load balancer with which we work.
+ * @param server_id: The id of the server.
+ * @param replica_idx: The index of the replica (0 -> the server itself).
  *
- * @param dst: Destination server.
- * @param src: Source server.
+ * @return - The position of the replica in the ring, or main->size
+ *      if the replica isn't in the ring.
 *******************************/
-void combine_databases(server_t *dst, server_t *src);
+u_int lb_find_replica(load_balancer_t *main, u_int server_id,
+					  u_int replica_idx);
 
 /******************************
-* lb_add_server_in_array() - Add a new server in the array of
+* lb_add_server_in_array() - Add a new server in the ring of
 *       a load balancer, without to redistribute the docs.
 *
 * @param main: The load balancer with which we work.
 * @param new_s: The new server.
 *
-* @return - The position of the new server in array.
+* @return - The position of the new server in ring.
 *******************************/
 u_int lb_add_server_in_array(load_balancer_t *main, server_t *new_s);
 
 /******************************
-* loader_add_replica() - Create and add a new replica of a server in a 
-*       load balancer and redistribute the docs from the load balancer. 
-*       (This function considers that the given server has a unique
-*       replica. The servers which are already in the system can have 
-*       more replicas.)
+* loader_add_replica() - Add a replica of a server in the ring of a
+*       load balancer and move in the server the docs from the arc
+*       taken by the replica. (The docs are put just in the database,
+*       not and in the cache, so they are compressed if it's enabled.)
 *
 * @param main: Load balancer with which we work.
-* @param server_id: ID of the new replica / server.
-* @param cache_size: Maximum number of documents which
-*       can be stored in the cache of the new replica.
-*
-* @return - The new replica.
+* @param rpl: The new replica (its id, replica_idx and hash_id must
+*		be set).
 *******************************/
-server_t *loader_add_replica(load_balancer_t* main, u_int server_id,
-						   u_int cache_size);
+void loader_add_replica(load_balancer_t *main, server_t *rpl);
 
 /******************************
  * create_replica_of_server() - Create a replica for a server.
  *
  * @param s: The mom server.
- * @param id: ID of the replica.
- * @param hash_id: The hash of the replica's ID.
+ * @param replica_idx: The index of the replica (it has the id of
+ *		the mom server).
+ * @param hash_id: The hash of the replica (see hash_replica()).
  *
  * @return - The created replica.
 *******************************/
-server_t *create_replica_of_server(server_t *s, u_int id, u_int hash_id);
+server_t *create_replica_of_server(server_t *s, u_int replica_idx,
+								   u_int hash_id);
 
 /******************************
- * loader_add_server() - Adds a new server to the system.
+ * loader_add_server() - Adds a new server to the system, with
+ *      main->replicas replicas.
  * 
  * @param main: Load balancer which distributes the work.
  * @param server_id: ID of the new server.
@@ -103,22 +153,38 @@ void
 loader_add_server(load_balancer_t *main, u_int server_id, u_int cache_size);
 
 /******************************
-* loader_remove_replica() - Remove a replica of a server from a load
-*       balancer and redistribute the docs from the load balancer. 
-*       (This function considers that the given server has a unique
-*       replica. The others servers which are in the system can have 
-*       more replicas.)
-*
-* @param main: Load balancer with which we work.
-* @param server_id: ID of the replica / server
+ * loader_add_server_weighted() - Adds a new server to the system, with
+ *      main->replicas * weight replicas. So, the number of docs for
+ *      which the server is responsible is proportional with its weight.
+ *
+ * @param main: Load balancer which distributes the work.
+ * @param server_id: ID of the new server.
+ * @param cache_size: Capacity of the new server's cache.
+ * @param weight: The weight / capacity of the server (at least 1;
+ *		main->replicas * weight must be at most MAX_REPLICAS).
+*******************************/
+void loader_add_server_weighted(load_balancer_t *main, u_int server_id,
+								u_int cache_size, u_int weight);
+
+/******************************
+ * lb_redistribute_docs() - Move every doc of a server, which isn't
+ *		anymore in the ring, in the server which is now responsible
+ *		for it. (The docs are put just in the database, not and in
+ *		the cache, so they are compressed if it's enabled.) The docs
+ *		aren't copied: they are taken out from the source server and
+ *		linked in the destination servers.
+ *
+ * @param main: Load balancer with which we work.
+ * @param src: The server whose docs are moved.
 *******************************/
-void loader_remove_replica(load_balancer_t *main, u_int server_id);
+void lb_redistribute_docs(load_balancer_t *main, server_t *src);
 
 /******************************
  * loader_remove_server() Removes a server from the system.
  * 
  * @param main: Load balancer which distributes the work.
- * @param server_id: ID of the server to be removed.
+ * @param server_id: ID of the server to be removed (its replicas
+ *        have the same id).
  * 
  * @brief Removes the server (and its replicas) from the hash ring
  * and distribute ALL documents stored on the removed server
@@ -129,6 +195,18 @@ void loader_remove_replica(load_balancer_t *main, u_int server_id);
 *******************************/
 void loader_remove_server(load_balancer_t *main, u_int server_id);
 
+/******************************
+ * loader_route_request() - Find the server which must do a request,
+ *		without to send the request to it.
+ *
+ * @param main: Load balancer which distributes the work.
+ * @param req: Request to be routed (its name must be interned with
+ *		main->names, so it has the hash).
+ *
+ * @return server_t* - The replica responsible for the doc.
+*******************************/
+server_t *loader_route_request(load_balancer_t *main, request_t *req);
+
 /******************************
  * loader_forward_request() - Forwards a request to the appropriate server.
  * 
@@ -140,6 +218,26 @@ void loader_remove_server(load_balancer_t *main, u_int server_id);
 *******************************/
 response_t *loader_forward_request(load_balancer_t *main, request_t *req);
 
+/******************************
+ * loader_flush_servers() - Do the tasks which the GETs left in the
+ *		queues of the servers with the targeted flush, so every task
+ *		which would have been done without it gives its response. The
+ *		tasks which no GET reached stay in queue, like without the
+ *		targeted flush.
+ *
+ * @param main: Load balancer with which we work.
+*******************************/
+void loader_flush_servers(load_balancer_t *main);
+
+/******************************
+ * loader_print_stats() - Print the statistics of the compression of
+ *		all the servers (also of the removed ones).
+ *
+ * @param main: Load balancer with which we work.
+ * @param f: The file in which they are printed.
+*******************************/
+void loader_print_stats(load_balancer_t *main, FILE *f);
+
 /******************************
  * free_load_balancer() - Deallocate completely the memory used by a
  *		load balancer.
@@ -7,10 +7,9 @@ lru_cache_t *init_lru_cache(u_int cache_capacity)
 	lru_cache_t *cache = (lru_cache_t *)malloc(sizeof(lru_cache_t));
 	DIE(cache == NULL, "malloc() failed\n");
 
-	// Allocate memory for every complex field from structure
-	cache->list_docs = cdll_create(sizeof(doc_t *));
-	cache->ht_docs = ht_create(1117, hash_string, compare_function_strings,
-					key_val_free_function);
+	// The list is empty. Its links are in the documents, so
+	// nothing else must be allocated.
+	cache->head = NULL;
 
 	// Initialize the parameters of the cache.
 	cache->size = 0;
@@ -33,16 +32,13 @@ void free_lru_cache(lru_cache_t **c)
 	lru_cache_t *cache = *c;
 
 	// Verify the cache.
-	if (!cache || !cache->list_docs || !cache->ht_docs) {
+	if (!cache) {
 		fprintf(stderr, "free_lru_cache() - cache isn't valid\n");
 		return;
 	}
 
-	// Free the memory of the list.
-	cdll_free(&cache->list_docs);
-	// Freee the memory of the hashtable.
-	ht_free(&cache->ht_docs);
-	// Free the memory of the cache's structure.
+	// Free the memory of the cache's structure. The documents
+	// belong to the database.
 	free(cache);
 
 	// Lose the address of the cache, which
@@ -50,133 +46,132 @@ void free_lru_cache(lru_cache_t **c)
 	*c = NULL;
 }
 
-u_int lru_cache_has_key(lru_cache_t *cache, void *key)
+u_int lru_cache_has_doc(doc_t *file)
 {
-	// Verify the parameters.
-	if (!cache) {
-		fprintf(stderr, "lru_cache_has_key() - the cache isn't valid\n");
-		return 0;
-	}
-	if (!key) {
-		fprintf(stderr, "lru_cache_has_key() - the key isn't valid\n");
-		return 0;
-	}
-
-	// Verify if the key is in cache.
-	if (ht_has_key(cache->ht_docs, key))
+	// Only the docs from cache have links.
+	if (file && file->lru_next)
 		return 1;
 	return 0;
 }
-void lru_cache_put(lru_cache_t *cache, void *key, void *value,
-				   void **evicted_key)
-{
-	// Verify the parameters.
-	if (!cache || !key || !value || !evicted_key) {
-		fprintf(stderr, "lru_cache_put() - at least one parameter isn't valid\n");
-		return;
-	}
 
-	// If the cache is full and the received key isn't already
-	// in cache, we must make place for it and to evacute / eliminate
-	// the key which was used the least recently.
-	if (!lru_cache_has_key(cache, key) && lru_cache_is_full(cache)) {
-		// Find the least recent document.
-		doc_t *file = *(doc_t **)cache->list_docs->head->data;
-		// Save the key which will remove from cache.
-		*evicted_key = (char *)malloc(strlen(file->name) + 1);
-		DIE(*evicted_key == NULL, "malloc() failed\n");
-		strcpy(*evicted_key, file->name);
-		// Remove the key from cache.
-		lru_cache_remove(cache, file->name);
+// Take out a document from the list of the cache.
+static void lru_cache_unlink(lru_cache_t *cache, doc_t *file)
+{
+	if (file->lru_next == file) {
+		// It was the only document.
+		cache->head = NULL;
 	} else {
-		*evicted_key = NULL;
+		// Breaks the links with its neighbors.
+		file->lru_prev->lru_next = file->lru_next;
+		file->lru_next->lru_prev = file->lru_prev;
+		// Update the head if it's the case.
+		if (cache->head == file)
+			cache->head = file->lru_next;
 	}
 
-	// If the current key is already in the cache, we must remove it,
-	// before to add it.
-	if (lru_cache_has_key(cache, key))
-		lru_cache_remove(cache, key);
+	file->lru_prev = NULL;
+	file->lru_next = NULL;
+	cache->size--;
+}
+
+// Put a document at the end of the list of the cache (as the most
+// recent one).
+static void lru_cache_link_tail(lru_cache_t *cache, doc_t *file)
+{
+	doc_t *head = cache->head;
 
-	// Add the received pair key-value in the given cache.
-	cdll_add_nth_node(cache->list_docs, cache->list_docs->size, value);
-	dll_node_t *tail = cache->list_docs->head->prev;
-	ht_put(cache->ht_docs, key, strlen((char *)key) + 1,  &tail,
-		  sizeof(dll_node_t *));
+	if (!head) {
+		// The list is empty.
+		file->lru_prev = file;
+		file->lru_next = file;
+		cache->head = file;
+	} else {
+		// Put it between the tail and the head.
+		doc_t *tail = head->lru_prev;
+		tail->lru_next = file;
+		file->lru_prev = tail;
+		file->lru_next = head;
+		head->lru_prev = file;
+	}
 
-	// Increment the numbers of elements from cache.
 	cache->size++;
 }
 
-void *lru_cache_get(lru_cache_t *cache, void *key)
+bool lru_cache_put(lru_cache_t *cache, doc_t *file, doc_t **evicted_doc)
 {
 	// Verify the parameters.
-	if (!cache) {
-		fprintf(stderr, "lru_cache_remove() - the cache isn't valid\n");
-		return NULL;
+	if (!cache || !file || !evicted_doc) {
+		fprintf(stderr, "lru_cache_put() - at least one parameter isn't valid\n");
+		return false;
 	}
-	if (!cache->size) {
-		fprintf(stderr, "lru_cache_remove() - the cache is empty\n");
-		return NULL;
+	*evicted_doc = NULL;
+
+	// If the doc is already in cache, just make it the most recent one.
+	if (lru_cache_has_doc(file)) {
+		if (file == cache->head) {
+			// The list is circular, so the head becomes the tail if
+			// the head moves forward.
+			cache->head = file->lru_next;
+		} else if (file != cache->head->lru_prev) {
+			lru_cache_unlink(cache, file);
+			lru_cache_link_tail(cache, file);
+		}
+		return true;
 	}
-	if (!key) {
-		fprintf(stderr, "lru_cache_remove() - the key isn't valid\n");
-		return NULL;
+
+	// A cache without places can't keep anything.
+	if (!cache->max_size)
+		return false;
+
+	// If the cache is full, we must make place for the doc and to
+	// evacute / eliminate the doc which was used the least recently.
+	if (lru_cache_is_full(cache)) {
+		*evicted_doc = cache->head;
+		lru_cache_unlink(cache, cache->head);
 	}
-	// Verify if the received key is in the cache.
-	if (!lru_cache_has_key(cache, key))
-		return NULL;
 
-	// Find the node in which is stored the value
-	// associated with the given key.
-	dll_node_t *node = *(dll_node_t **)ht_get(cache->ht_docs, key);
+	// Add the doc as the most recent one.
+	lru_cache_link_tail(cache, file);
+
+	return false;
+}
+
+void lru_cache_replace(lru_cache_t *cache, doc_t *old_file, doc_t *new_file)
+{
+	// Verify if the old version is in cache.
+	if (!lru_cache_has_doc(old_file))
+		return;
+
+	// The new version takes the links of the old one.
+	if (old_file->lru_next == old_file) {
+		new_file->lru_prev = new_file;
+		new_file->lru_next = new_file;
+	} else {
+		new_file->lru_prev = old_file->lru_prev;
+		new_file->lru_next = old_file->lru_next;
+		old_file->lru_prev->lru_next = new_file;
+		old_file->lru_next->lru_prev = new_file;
+	}
+	if (cache->head == old_file)
+		cache->head = new_file;
 
-	// Return the value assicated with the key.
-	return *(doc_t **)node->data;
+	old_file->lru_prev = NULL;
+	old_file->lru_next = NULL;
 }
 
-bool lru_cache_remove(lru_cache_t *cache, void *key)
+bool lru_cache_remove(lru_cache_t *cache, doc_t *file)
 {
 	// Verify the parameters.
 	if (!cache) {
 		fprintf(stderr, "lru_cache_remove() - the cache isn't valid\n");
 		return false;
 	}
-	if (!cache->size) {
-		fprintf(stderr, "lru_cache_remove() - the cache is empty\n");
-		return false;
-	}
-	if (!key) {
-		fprintf(stderr, "lru_cache_remove() - the key isn't valid\n");
-		return false;
-	}
-
-	// Find the node which will remove from cache's list.
-	dll_node_t *node = *(dll_node_t **)ht_get(cache->ht_docs, key);
-
-	// Remove the node from the hashtable.
-	ht_remove_entry(cache->ht_docs, key);
 
-	// Will remove the node manually from the list.
-
-	// Breaks the links with its neighbors if has.
-	if (cache->list_docs->size >= 1) {
-		node->prev->next = node->next;
-		node->next->prev = node->prev;
-	}
-	// Update the head if it's the case.
-	if (node == cache->list_docs->head) {
-		if (cache->list_docs->size >= 1)
-			cache->list_docs->head = node->next;
-		else
-			cache->list_docs->head = NULL;
-	}
-	// Free the memory of the node.
-	free_cdll_node(node);
-	// Decrement the size of the list.
-	--cache->list_docs->size;
+	// If the doc isn't in cache, there is nothing to remove.
+	if (!lru_cache_has_doc(file))
+		return false;
 
-	// Decrement the number of documents from the cache.
-	cache->size--;
+	lru_cache_unlink(cache, file);
 
 	// The work finished successfully.
 	return true;
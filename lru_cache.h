@@ -5,8 +5,9 @@
 #include <stdio.h>
 #include <string.h>
 #include <stdbool.h>
-#include "list.h"
-#include "hash_map.h"
+#include "mem_pool.h"
+#include "names.h"
+#include "blob.h"
 #include "utils.h"
 
 /******************************
@@ -14,31 +15,39 @@
  * of a document.
 *******************************/
 typedef struct doc_t{
-    /* Name of the document. */
-    char *name;
-    /* Content of the document. */
-    char *content;
+    /* Name of the document (interned - shared with the requests). */
+    doc_name_t *name;
+    /* Content of the document (shared - an edit gives a new blob). */
+    blob_t *content;
+    /* The hash of the name (the position on the hash ring). */
+    u_int hash;
+    /* The links and the priority from the index of the server
+    which sorts the documents after their hashes. */
+    struct doc_t *idx_left;
+    struct doc_t *idx_right;
+    u_int idx_priority;
+    /* The links from the list of the cache (NULL, if the
+    document isn't in cache). */
+    struct doc_t *lru_prev;
+    struct doc_t *lru_next;
 } doc_t;
 
 /******************************
  * LRU CACHE is implemented using 1 circular
- * doubly linking list and 1 hashmap.
- * The pair key-value (name of document - 
- * pointer to the entire document) is saved using
- * those 2 structures.
- * value -> is saved in a node from list
- * key with the address of the node in which is stored
- * the value -> are saved in pair in hashtable
- * The name of docs from list should be stored in the
+ * doubly linking list, whose links are saved in
+ * the documents (so the cache doesn't allocate
+ * memory for them). A document is found after its
+ * name in the local database of the server, which
+ * keeps the same documents, so the cache doesn't
+ * need a hashtable.
+ * The docs from list should be stored in the
  * order of their use, so:
  * head - the least recent document used
  * tail - the most recent document used
 *******************************/
 typedef struct lru_cache_t {
-    /* The list with the values. */
-    cdll_t *list_docs;
-    /* The hashtable with the keys. */
-    hashtable_t *ht_docs;
+    /* The least recent document (NULL, if the cache is empty). */
+    doc_t *head;
     /* The current number of elements from cache. */
     u_int size;
     /* The maximum number of elements from cache. */
@@ -67,55 +76,58 @@ lru_cache_t *init_lru_cache(unsigned int cache_capacity);
 bool lru_cache_is_full(lru_cache_t *cache);
 
 /******************************
- * free_lru_cache() - Free the memory allocated for a cache.
- * 
+ * free_lru_cache() - Free the memory allocated for a cache. (The
+ *      documents are freed by the database which keeps them.)
+ *
  * @param cache: Addreess which points at the cache's address.
 *******************************/
 void free_lru_cache(lru_cache_t **cache);
 
 /******************************
-* lru_cache_has_key() - Verify if a key / doc is in a cache.
+* lru_cache_has_doc() - Verify if a doc is in a cache.
 *
-* @param cache: Cache with which we work.
-* @param key: The key which will be searched.
+* @param file: The document.
 *
-* @return 1, if the key is in the cache
+* @return 1, if the doc is in the cache
 *         0, if isn't
 *******************************/
-u_int lru_cache_has_key(lru_cache_t *cache, void *key);
+u_int lru_cache_has_doc(doc_t *file);
 
 /******************************
- * lru_cache_put() - Adds a new pair in our cache.
+ * lru_cache_put() - Adds a document in our cache. If it's already
+ *      there, it's just moved at the end of the most recent documents.
  * 
- * @param cache: Cache where the key-value pair will be stored.
- * @param key: Key of the pair.
- * @param value: Value of the pair.
- * @param evicted_key: The function will RETURN via this parameter the
- *      key removed from cache if the cache was full.
+ * @param cache: Cache where the doc will be stored.
+ * @param file: The document.
+ * @param evicted_doc: The function will RETURN via this parameter the
+ *      doc removed from cache if the cache was full (the doc stays
+ *      in database).
+ *
+ * @return - TRUE if the doc was already in cache (hit),
+ *           FALSE if it was added (miss).
 *******************************/
-void lru_cache_put(lru_cache_t *cache, void *key, void *value,
-                   void **evicted_key);
+bool lru_cache_put(lru_cache_t *cache, doc_t *file, doc_t **evicted_doc);
 
 /******************************
- * lru_cache_get() - Retrieves the value associated with a key.
- * 
- * @param cache: Cache where the key-value pair is stored.
- * @param key: Key of the pair.
+ * lru_cache_replace() - Put a new version of a document in the place
+ *      of the old one, if the old one is in cache.
  * 
- * @return - The value associated with the key,
- *           or NULL if the key is not found.
+ * @param cache: Cache with which we work.
+ * @param old_file: The old version (it's taken out from cache).
+ * @param new_file: The new version.
 *******************************/
-void *lru_cache_get(lru_cache_t *cache, void *key);
+void lru_cache_replace(lru_cache_t *cache, doc_t *old_file, doc_t *new_file);
 
 /******************************
- * lru_cache_remove() - Removes a key-value pair from the cache.
+ * lru_cache_remove() - Removes a document from the cache.
  * 
- * @param cache: Cache where the key-value pair is stored.
- * @param key: Key of the pair.
+ * @param cache: Cache where the document is stored.
+ * @param file: The document.
  *
  * @return - TRUE if the remove operation can take place,
- *           FALSE if can not take place.
+ *           FALSE if can not take place (also if the doc isn't
+ *           in cache).
 *******************************/
-bool lru_cache_remove(lru_cache_t *cache, void *key);
+bool lru_cache_remove(lru_cache_t *cache, doc_t *file);
 
 #endif
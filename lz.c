@@ -0,0 +1,165 @@
+// Copyright Necula Mihail 313CAa 2023-2024
+#include "lz.h"
+
+// Read 4 bytes from any address.
+static u_int lz_read32(const char *p)
+{
+	u_int value;
+	memcpy(&value, p, sizeof(value));
+	return value;
+}
+
+// Find the entry of a group of 4 bytes in the table of positions.
+static u_int lz_hash(u_int value)
+{
+	return (value * 2654435761u) >> (32 - LZ_HASH_BITS);
+}
+
+// Write the rest of a length which doesn't fit in its 4 bits of token.
+// Return the next position or 0 if there isn't enough place.
+static u_int lz_put_length(char *dst, u_int pos, u_int cap, u_int len)
+{
+	for (; len >= 255; len -= 255) {
+		if (pos == cap)
+			return 0;
+		dst[pos++] = (char)255;
+	}
+	if (pos == cap)
+		return 0;
+	dst[pos++] = (char)len;
+	return pos;
+}
+
+// Write a group: the literals and, if match_len isn't 0, the match.
+// Return the next position or 0 if there isn't enough place.
+static u_int lz_put_group(char *dst, u_int pos, u_int cap,
+						  const char *literals, u_int lit_len,
+						  u_int offset, u_int match_len)
+{
+	u_int lit_code = lit_len < 15 ? lit_len : 15;
+	u_int match_code = 0;
+	if (match_len)
+		match_code = match_len - LZ_MIN_MATCH < 15 ?
+					 match_len - LZ_MIN_MATCH : 15;
+
+	// The token and the literals.
+	if (pos == cap)
+		return 0;
+	dst[pos++] = (char)(lit_code << 4 | match_code);
+	if (lit_code == 15 && !(pos = lz_put_length(dst, pos, cap, lit_len - 15)))
+		return 0;
+	if (lit_len > cap - pos)
+		return 0;
+	memcpy(dst + pos, literals, lit_len);
+	pos += lit_len;
+
+	// The last group doesn't have a match.
+	if (!match_len)
+		return pos;
+
+	// The offset and the rest of the length of the match.
+	if (cap - pos < 2)
+		return 0;
+	dst[pos++] = (char)(offset & 0xff);
+	dst[pos++] = (char)(offset >> 8);
+	if (match_code == 15)
+		pos = lz_put_length(dst, pos, cap, match_len - LZ_MIN_MATCH - 15);
+	return pos;
+}
+
+u_int lz_compress(const char *src, u_int size, char *dst, u_int cap)
+{
+	// The last positions of the groups of 4 bytes (position + 1, 0 means
+	// that the group wasn't seen).
+	u_int table[1 << LZ_HASH_BITS];
+	memset(table, 0, sizeof(table));
+
+	u_int pos = 0, anchor = 0, out = 0;
+	while (pos + LZ_MIN_MATCH <= size) {
+		// Find the last position of the same group of bytes.
+		u_int group = lz_read32(src + pos);
+		u_int *entry = &table[lz_hash(group)];
+		u_int cand = *entry;
+		*entry = pos + 1;
+		if (!cand || pos - (cand - 1) > LZ_MAX_OFFSET ||
+			lz_read32(src + cand - 1) != group) {
+			pos++;
+			continue;
+		}
+		cand--;
+
+		// Extend the match as much as possible.
+		u_int len = LZ_MIN_MATCH;
+		while (pos + len < size && src[cand + len] == src[pos + len])
+			len++;
+
+		// Write the literals before it and the match.
+		out = lz_put_group(dst, out, cap, src + anchor, pos - anchor,
+						   pos - cand, len);
+		if (!out)
+			return 0;
+		pos += len;
+		anchor = pos;
+	}
+
+	// The rest of the bytes are literals.
+	return lz_put_group(dst, out, cap, src + anchor, size - anchor, 0, 0);
+}
+
+// Read the rest of a length. Return false if the data ends before.
+static bool lz_get_length(const unsigned char *src, u_int packed_size,
+						  u_int *pos, u_int *len)
+{
+	unsigned char byte;
+	do {
+		if (*pos == packed_size)
+			return false;
+		byte = src[(*pos)++];
+		*len += byte;
+	} while (byte == 255);
+	return true;
+}
+
+bool lz_decompress(const char *src, u_int packed_size, char *dst,
+				   u_int size)
+{
+	const unsigned char *in = (const unsigned char *)src;
+	u_int pos = 0, out = 0;
+
+	while (pos < packed_size) {
+		// The token.
+		u_int token = in[pos++];
+		u_int lit_len = token >> 4;
+		if (lit_len == 15 && !lz_get_length(in, packed_size, &pos, &lit_len))
+			return false;
+
+		// The literals.
+		if (lit_len > packed_size - pos || lit_len > size - out)
+			return false;
+		memcpy(dst + out, in + pos, lit_len);
+		pos += lit_len;
+		out += lit_len;
+
+		// The last group doesn't have a match.
+		if (pos == packed_size)
+			break;
+
+		// The match, which can overlap the bytes which it writes, so
+		// it's copied byte by byte.
+		if (packed_size - pos < 2)
+			return false;
+		u_int offset = in[pos] | (u_int)in[pos + 1] << 8;
+		pos += 2;
+		u_int match_len = token & 15;
+		if (match_len == 15 &&
+			!lz_get_length(in, packed_size, &pos, &match_len))
+			return false;
+		match_len += LZ_MIN_MATCH;
+		if (!offset || offset > out || match_len > size - out)
+			return false;
+		for (u_int i = 0; i < match_len; ++i, ++out)
+			dst[out] = dst[out - offset];
+	}
+
+	return out == size;
+}
@@ -0,0 +1,56 @@
+// Copyright Necula Mihail 313CAa 2023-2024
+#ifndef LZ_H
+#define LZ_H
+
+#include <stdbool.h>
+#include <string.h>
+#include "utils.h"
+
+/* The shortest match which is encoded (shorter ones are literals). */
+#define LZ_MIN_MATCH		4
+/* The table of the last positions has 2^LZ_HASH_BITS entries. */
+#define LZ_HASH_BITS		12
+/* The farthest match (the offset is kept on 2 bytes). */
+#define LZ_MAX_OFFSET		65535
+
+/******************************
+ * A fast compressor from the LZ77 family, in the style of LZ4. The
+ * compressed data is a sequence of groups:
+ *	- a token: the number of literals (4 bits) and the length of the
+ *	  match - LZ_MIN_MATCH (4 bits); 15 means that the rest of the
+ *	  number follows in bytes of 255 and a last byte < 255
+ *	- the literals
+ *	- the offset of the match (2 bytes, little endian) and the rest of
+ *	  its length (missing for the last group, which has only literals)
+ * The matches are found with a table of the last positions of the
+ * groups of 4 bytes, so there is a single candidate for every position.
+*******************************/
+
+/******************************
+ * lz_compress() - Compress a buffer.
+ *
+ * @param src: The data.
+ * @param size: The number of bytes of data.
+ * @param dst: The buffer for the compressed data.
+ * @param cap: The number of bytes of dst.
+ *
+ * @return - The number of bytes of the compressed data or 0 if it
+ *		doesn't fit in cap bytes.
+*******************************/
+u_int lz_compress(const char *src, u_int size, char *dst, u_int cap);
+
+/******************************
+ * lz_decompress() - Decompress a buffer given by lz_compress().
+ *
+ * @param src: The compressed data.
+ * @param packed_size: The number of bytes of compressed data.
+ * @param dst: The buffer for the data.
+ * @param size: The number of bytes of data.
+ *
+ * @return - true if exactly size bytes were decompressed, false if the
+ *		compressed data is damaged.
+*******************************/
+bool lz_decompress(const char *src, u_int packed_size, char *dst,
+				   u_int size);
+
+#endif
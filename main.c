@@ -6,150 +6,97 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
 
 #include "load_balancer.h"
+#include "driver.h"
 #include "lru_cache.h"
+#include "parser.h"
+#include "trace.h"
+#include "worker.h"
 #include "utils.h"
 #include "constants.h"
 
-void read_quoted_string(char *buffer, int buffer_len, int *start, int *end) {
-    *end = -1;
+void apply_requests(parser_t *parser, int requests_num,
+                    unsigned int replicas, unsigned int threads,
+                    bool targeted_flush, const hash_family_t *hash,
+                    bool compress) {
+    parsed_request_t req;
 
-    for (int i = 0; i < buffer_len && buffer[i] != '\0'; ++i) {
-        if (buffer[i] != '"')
-            continue;
+    load_balancer_t *main = init_load_balancer(replicas, hash);
+    main->targeted_flush = targeted_flush;
+    main->compress = compress;
 
-        if (*start == -1) {
-            *start = i;
-        } else {
-            *end = i;
-            break;
-        }
-    }
-}
-
-request_type read_request_arguments(FILE *input_file, char *buffer,
-    int *maybe_server_id, int *maybe_cache_size,
-    char **maybe_doc_name, char **maybe_doc_content)
-{
-    request_type req_type;
-    int word_start = -1;
-    int word_end = -1;
-
-    DIE(fgets(buffer, REQUEST_LENGTH + 1, input_file) == NULL,
-        "insufficient requests");
-
-    req_type = get_request_type(buffer);
-
-    if (req_type == ADD_SERVER) {
-        *maybe_server_id = atoi(buffer + strlen(ADD_SERVER_REQUEST) + 1);
-        *maybe_cache_size = atoi(strchr(
-            buffer + strlen(ADD_SERVER_REQUEST) + 1, ' '));
-    } else if (req_type == REMOVE_SERVER) {
-        *maybe_server_id = atoi(buffer + strlen(REMOVE_SERVER_REQUEST) + 1);
-    } else {
-        *maybe_doc_name = calloc(1, DOC_NAME_LENGTH + 1);
-        DIE(*maybe_doc_name == NULL, "calloc failed");
-
-        read_quoted_string(buffer, REQUEST_LENGTH, &word_start, &word_end);
-        memcpy(*maybe_doc_name, buffer + word_start + 1,
-            word_end - word_start - 1);
-
-        if (req_type == EDIT_DOCUMENT) {
-            char *tmp_buffer = buffer + word_end + 1;
-
-            *maybe_doc_content = calloc(1, DOC_CONTENT_LENGTH + 1);
-            DIE(*maybe_doc_content == NULL, "calloc failed");
-
-            /* Read the content, which might be a multiline quoted string */
-            word_start = -1;
-            read_quoted_string(tmp_buffer, DOC_CONTENT_LENGTH,
-                &word_start, &word_end);
-
-            if (word_end == -1)
-                strcpy(*maybe_doc_content, tmp_buffer + word_start + 1);
-            else
-                strncpy(*maybe_doc_content, tmp_buffer + word_start + 1,
-                    word_end - word_start - 1);
-
-            while (word_end == -1) {
-                DIE(fgets(buffer, DOC_CONTENT_LENGTH + 1, input_file) == NULL,
-                    "document content is not properly quoted");
-
-                read_quoted_string(buffer, DOC_CONTENT_LENGTH,
-                    &word_start, &word_end);
-                memcpy(*maybe_doc_content + strlen(*maybe_doc_content), buffer,
-                    word_end == -1 ? strlen(buffer) : (unsigned) word_end);
-            }
-        } else {
-            *maybe_doc_content = NULL;
-        }
-    }
-
-    return req_type;
-}
-
-void apply_requests(FILE  *input_file, char *buffer,
-                    int requests_num, bool enable_vnodes) {
-    char *doc_name, *doc_content;
-    int server_id, cache_size;
-
-    load_balancer_t *main = init_load_balancer(enable_vnodes);
+    /* With threads, the load balancer only routes the requests */
+    worker_pool_t *pool = threads ? worker_pool_create(threads) : NULL;
 
     for (int i = 0; i < requests_num; i++) {
-        request_type req_type = read_request_arguments(input_file, buffer,
-            &server_id, &cache_size, &doc_name, &doc_content);
-
-        if (req_type == ADD_SERVER) {
-            DIE(cache_size < 0, "cache size must be positive");
-            loader_add_server(main, server_id, (unsigned int) cache_size);
-        } else if (req_type == REMOVE_SERVER) {
-            loader_remove_server(main, server_id);
-        } else {
-            request_t server_request = {
-                .type = req_type,
-                .doc_name = doc_name,
-            };
-
-            if (req_type == EDIT_DOCUMENT) {
-                server_request.doc_content = doc_content;
-            }
+        /* The strings of the request point in the input */
+        parser_next_request(parser, &req);
+        apply_request(main, pool, &req);
+    }
 
-            response_t *response = loader_forward_request(main,
-                                    &server_request);
+    if (pool)
+        worker_pool_free(&pool);
 
-            free(server_request.doc_name);
-            free(server_request.doc_content);
-
-            PRINT_RESPONSE(response);
-        }
-    }
+    /* The edits left in queue by the targeted flush give their responses */
+    loader_flush_servers(main);
 
+    /* The cost of the compression goes to stderr, out of the output */
+    if (compress)
+        loader_print_stats(main, stderr);
     free_load_balancer(&main);
+    pool_cleanup();
 }
 
 int main(int argc, char **argv) {
-    FILE *input;
+    parser_t *parser;
     int requests_num;
-    bool enable_vnodes;
-
-    char buffer[REQUEST_LENGTH + 1];
+    unsigned int replicas, threads = 0;
+    bool targeted_flush = false, compress = false;
+    const hash_family_t *hash = &hash_families[0];
+    output_format_t output_format = OUTPUT_TEXT;
 
     if (argc < 2) {
-        printf("Usage: %s <input_file>\n", argv[0]);
+        printf("Usage: %s <input_file> [%s] [%s <threads>] [%s] "
+            "[%s <hash>] [%s] [%s <binary_trace>]\n", argv[0],
+            BINARY_OUTPUT_OPTION, THREADS_OPTION, TARGETED_FLUSH_OPTION,
+            HASH_OPTION, COMPRESS_OPTION, CONVERT_OPTION);
         return -1;
     }
 
-    input = fopen(argv[1], "rt");
-    DIE(input == NULL, "missing input file");
+    for (int i = 2; i < argc; i++) {
+        if (!strcmp(argv[i], BINARY_OUTPUT_OPTION)) {
+            output_format = OUTPUT_BINARY;
+        } else if (!strcmp(argv[i], THREADS_OPTION) && i + 1 < argc) {
+            threads = (unsigned int) atoi(argv[++i]);
+        } else if (!strcmp(argv[i], TARGETED_FLUSH_OPTION)) {
+            targeted_flush = true;
+        } else if (!strcmp(argv[i], HASH_OPTION) && i + 1 < argc) {
+            hash = get_hash_family(argv[++i]);
+            DIE(!hash, "unknown hash family");
+        } else if (!strcmp(argv[i], COMPRESS_OPTION)) {
+            compress = true;
+        } else if (!strcmp(argv[i], CONVERT_OPTION) && i + 1 < argc) {
+            /* Just convert the text trace in a binary trace */
+            trace_convert(argv[1], argv[i + 1]);
+            return 0;
+        } else {
+            DIE(1, "unknown option");
+        }
+    }
 
-    DIE(fgets(buffer, REQUEST_LENGTH + 1, input) == 0, "empty input file");
-    requests_num = atoi(buffer);
-    enable_vnodes = strstr(buffer, "ENABLE_VNODES");
+    /* The input (text or binary trace) is mapped and parsed in place */
+    parser = parser_open(argv[1]);
+    parser_read_header(parser, &requests_num, &replicas);
 
-    apply_requests(input, buffer, requests_num, enable_vnodes);
+    /* The responses are gathered in a buffer and written in batches */
+    output_open(STDOUT_FILENO, output_format);
+    apply_requests(parser, requests_num, replicas, threads, targeted_flush,
+                   hash, compress);
+    output_close();
 
-    fclose(input);
+    parser_close(&parser);
 
     return 0;
 }
@@ -0,0 +1,105 @@
+// Copyright Necula Mihail 313CAa 2023-2024
+#include <pthread.h>
+#include "mem_pool.h"
+
+/* The lists with the free blocks of every size class. Every thread
+has its own lists, so the blocks are taken / given back without locks.
+(A block freed by other thread goes in the lists of that thread.) */
+static __thread pool_block_t *free_blocks[POOL_CLASSES];
+/* The list with the allocated slabs (linked through their first bytes). */
+static void *slabs;
+/* Protects the list of slabs, which is common for all the threads. */
+static pthread_mutex_t slabs_lock = PTHREAD_MUTEX_INITIALIZER;
+
+// Find the size class of a block with the given size.
+static size_t pool_size_class(size_t size)
+{
+	size_t size_class = 0;
+	while (size_class < POOL_CLASSES &&
+		   ((size_t)1 << (size_class + POOL_MIN_SHIFT)) < size)
+		++size_class;
+
+	return size_class;
+}
+
+// Cut a new slab in free blocks of the given class.
+static void pool_add_slab(size_t size_class)
+{
+	size_t block_size = sizeof(pool_block_t) +
+						((size_t)1 << (size_class + POOL_MIN_SHIFT));
+	size_t slab_size = POOL_SLAB_SIZE;
+	if (slab_size < 8 * block_size)
+		slab_size = 8 * block_size;
+
+	// Allocate the slab. The first bytes link it with the others slabs.
+	char *slab = (char *)malloc(sizeof(pool_block_t) + slab_size);
+	DIE(slab == NULL, "malloc() failed\n");
+	pthread_mutex_lock(&slabs_lock);
+	*(void **)slab = slabs;
+	slabs = slab;
+	pthread_mutex_unlock(&slabs_lock);
+
+	// Put every block from slab in the list of its class.
+	for (size_t i = 0; i + block_size <= slab_size; i += block_size) {
+		pool_block_t *block = (pool_block_t *)(slab + sizeof(pool_block_t) + i);
+		block->size_class = size_class;
+		block->next = free_blocks[size_class];
+		free_blocks[size_class] = block;
+	}
+}
+
+void *pool_alloc(size_t size)
+{
+	size_t size_class = pool_size_class(size);
+
+	// The big blocks are allocated directly.
+	if (size_class == POOL_CLASSES) {
+		pool_block_t *block = (pool_block_t *)malloc(sizeof(pool_block_t)
+													 + size);
+		DIE(block == NULL, "malloc() failed\n");
+		block->size_class = POOL_CLASSES;
+		return block + 1;
+	}
+
+	// Take the first free block of the class.
+	if (!free_blocks[size_class])
+		pool_add_slab(size_class);
+	pool_block_t *block = free_blocks[size_class];
+	free_blocks[size_class] = block->next;
+
+	return block + 1;
+}
+
+void pool_free(void *ptr)
+{
+	if (!ptr)
+		return;
+
+	// Find the header of the block.
+	pool_block_t *block = (pool_block_t *)ptr - 1;
+
+	// The big blocks are freed directly.
+	if (block->size_class == POOL_CLASSES) {
+		free(block);
+		return;
+	}
+
+	// Put back the block in the list of its class.
+	block->next = free_blocks[block->size_class];
+	free_blocks[block->size_class] = block;
+}
+
+void pool_cleanup(void)
+{
+	// Free every slab.
+	while (slabs) {
+		void *next = *(void **)slabs;
+		free(slabs);
+		slabs = next;
+	}
+
+	// The lists of free blocks are now empty. (The others threads
+	// must be stopped before this call.)
+	for (size_t i = 0; i < POOL_CLASSES; ++i)
+		free_blocks[i] = NULL;
+}
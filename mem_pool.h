@@ -0,0 +1,53 @@
+// Copyright Necula Mihail 313CAa 2023-2024
+#ifndef MEM_POOL_H
+#define MEM_POOL_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "utils.h"
+
+/* The smallest size class has 2^POOL_MIN_SHIFT bytes. */
+#define POOL_MIN_SHIFT		4
+/* The number of size classes (16 B, 32 B, ..., 8 KiB). The bigger
+blocks are allocated directly with malloc(). */
+#define POOL_CLASSES		10
+/* The size of a slab from which are cut the blocks of a class. */
+#define POOL_SLAB_SIZE		(64 * 1024)
+
+/******************************
+ * The header which is put before every block given by pool_alloc().
+ * While the block is free, it's linked in the list of its class.
+*******************************/
+typedef struct pool_block_t {
+	/* The size class of the block (POOL_CLASSES -> big block). */
+	size_t size_class;
+	/* The next free block of the same class. */
+	struct pool_block_t *next;
+} pool_block_t;
+
+/******************************
+ * pool_alloc() - Allocate a block of memory from the slab of
+ *		its size class.
+ *
+ * @param size: The number of bytes.
+ *
+ * @return - The address of the block.
+*******************************/
+void *pool_alloc(size_t size);
+
+/******************************
+ * pool_free() - Give back a block to its size class, to be used
+ *		again. (NULL is ignored.)
+ *
+ * @param ptr: The address returned by pool_alloc().
+*******************************/
+void pool_free(void *ptr);
+
+/******************************
+ * @brief Free the memory of all the slabs. The blocks given by the
+ *		pool can't be used anymore after this call. (It must be called
+ *		after all the others threads which used the pool stopped.)
+*******************************/
+void pool_cleanup(void);
+
+#endif
@@ -0,0 +1,110 @@
+// Copyright Necula Mihail 313CAa 2023-2024
+#include "names.h"
+
+// Compare 2 names (the keys of the table).
+static int names_compare(const void *a, const void *b)
+{
+	return strcmp((const char *)a, (const char *)b);
+}
+
+name_table_t *names_create(unsigned int (*hash_function)(void *))
+{
+	// Allocate memory for the table's structure.
+	name_table_t *nt = (name_table_t *)malloc(sizeof(name_table_t));
+	DIE(nt == NULL, "malloc() failed\n");
+
+	// The table is empty.
+	nt->table = flat_table_create(names_compare);
+	nt->names = NULL;
+	nt->size = 0;
+	nt->max_size = 0;
+	nt->trace_names = NULL;
+	nt->trace_names_size = 0;
+	nt->hash_function = hash_function;
+
+	// Return the created table.
+	return nt;
+}
+
+// Remember the record of a name from a binary trace.
+static void names_set_trace_id(name_table_t *nt, u_int trace_id,
+							   doc_name_t *name)
+{
+	// Make place for the id (the new places are empty).
+	if (trace_id >= nt->trace_names_size) {
+		u_int new_size = nt->trace_names_size ? nt->trace_names_size : 16;
+		while (new_size <= trace_id)
+			new_size *= 2;
+		nt->trace_names = (doc_name_t **)realloc(nt->trace_names,
+								new_size * sizeof(doc_name_t *));
+		DIE(nt->trace_names == NULL, "realloc() failed\n");
+		memset(nt->trace_names + nt->trace_names_size, 0,
+			   (new_size - nt->trace_names_size) * sizeof(doc_name_t *));
+		nt->trace_names_size = new_size;
+	}
+
+	nt->trace_names[trace_id] = name;
+}
+
+doc_name_t *names_intern(name_table_t *nt, const char *str, int trace_id)
+{
+	// A name from a binary trace which was seen is found after its id.
+	if (trace_id >= 0 && (u_int)trace_id < nt->trace_names_size &&
+		nt->trace_names[trace_id])
+		return nt->trace_names[trace_id];
+
+	// Search the name.
+	u_int hash = nt->hash_function((void *)str);
+	flat_entry_t *entry = flat_table_find(nt->table, str, hash);
+	doc_name_t *name = entry ? (doc_name_t *)entry->value : NULL;
+
+	if (!name) {
+		// Allocate the record and the name in the same block.
+		size_t len = strlen(str) + 1;
+		name = (doc_name_t *)malloc(sizeof(doc_name_t) + len);
+		DIE(name == NULL, "malloc() failed\n");
+		name->str = (char *)(name + 1);
+		memcpy(name->str, str, len);
+		name->len = (u_int)(len - 1);
+		name->hash = hash;
+
+		// Give it the next id.
+		if (nt->size == nt->max_size) {
+			nt->max_size = nt->max_size ? 2 * nt->max_size : 16;
+			nt->names = (doc_name_t **)realloc(nt->names,
+									nt->max_size * sizeof(doc_name_t *));
+			DIE(nt->names == NULL, "realloc() failed\n");
+		}
+		name->id = nt->size;
+		nt->names[nt->size++] = name;
+
+		flat_table_put(nt->table, name->str, hash, name);
+	}
+
+	if (trace_id >= 0)
+		names_set_trace_id(nt, (u_int)trace_id, name);
+
+	// Return the record.
+	return name;
+}
+
+void names_free(name_table_t **nt)
+{
+	// Get the table's address.
+	name_table_t *t = *nt;
+	if (!t)
+		return;
+
+	// Free the memory of the records.
+	for (u_int i = 0; i < t->size; ++i)
+		free(t->names[i]);
+	free(t->names);
+	free(t->trace_names);
+	flat_table_free(&t->table);
+
+	// Free the memory of the table's structure.
+	free(t);
+
+	// Lose the address of the table, which doesn't exist anymore.
+	*nt = NULL;
+}
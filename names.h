@@ -0,0 +1,74 @@
+// Copyright Necula Mihail 313CAa 2023-2024
+#ifndef NAMES_H
+#define NAMES_H
+
+#include "flat_table.h"
+#include "utils.h"
+
+/******************************
+ * An interned name of a document. Every name is kept once, so two
+ * requests / docs with the same name point at the same record and
+ * the names can be compared after their addresses.
+*******************************/
+typedef struct doc_name_t {
+	/* The name (kept in the same block as the record). */
+	char *str;
+	/* The length of the name (without the terminator). */
+	u_int len;
+	/* The hash of the name (the position on the hash ring). */
+	u_int hash;
+	/* The id of the name (the order in which the names were seen). */
+	u_int id;
+} doc_name_t;
+
+/******************************
+ * The table with the interned names. It's modified only by the
+ * thread which reads the input; the records never move, so they can
+ * be read by the other threads.
+*******************************/
+typedef struct name_table_t {
+	/* The names: pairs string - record (doc_name_t *). */
+	flat_table_t *table;
+	/* The records, indexed by their ids. */
+	doc_name_t **names;
+	/* The number of names. */
+	u_int size;
+	/* The number of records which can be kept in names. */
+	u_int max_size;
+	/* The records of the names from a binary trace, indexed by their
+	ids from trace (NULL -> the name wasn't seen yet). */
+	doc_name_t **trace_names;
+	/* The number of places from trace_names. */
+	u_int trace_names_size;
+	/* The function which hashes the names. */
+	unsigned int (*hash_function)(void *);
+} name_table_t;
+
+/******************************
+ * names_create() - Create an empty table of names.
+ *
+ * @param hash_function: The function which hashes the names.
+ *
+ * @return - The created table.
+*******************************/
+name_table_t *names_create(unsigned int (*hash_function)(void *));
+
+/******************************
+ * names_intern() - Find the record of a name. If the name is new, it's
+ *		copied, hashed and receives the next id.
+ *
+ * @param nt: The table with which we work.
+ * @param str: The name.
+ * @param trace_id: The id of the name from a binary trace (its record is
+ *		found without to hash the name) or -1 (a text trace).
+ *
+ * @return - The record of the name.
+*******************************/
+doc_name_t *names_intern(name_table_t *nt, const char *str, int trace_id);
+
+/******************************
+ * @brief Free the memory of a table of names and of its records.
+*******************************/
+void names_free(name_table_t **nt);
+
+#endif
@@ -0,0 +1,195 @@
+// Copyright Necula Mihail 313CAa 2023-2024
+#include <unistd.h>
+#include "output.h"
+#include "utils.h"
+
+/* The output stage of the program. */
+static output_t out = {STDOUT_FILENO, OUTPUT_TEXT, NULL, 0, 0};
+/* Verify if output_close() was registered to be called at exit. */
+static bool registered;
+/* The buffer where the current thread captures its responses
+(NULL -> the responses go in the output stage). */
+static __thread output_t *capture_buff;
+
+// Write all the given bytes in the output file.
+static void output_write_all(const char *data, size_t len)
+{
+	while (len) {
+		ssize_t written = write(out.fd, data, len);
+		if (written < 0 && errno == EINTR)
+			continue;
+		DIE(written < 0, "write() failed");
+		data += written;
+		len -= (size_t)written;
+	}
+}
+
+// Append some bytes in a capture buffer, which grows if it's needed.
+static void output_capture_append(const char *data, size_t len)
+{
+	output_t *buff = capture_buff;
+	if (buff->size + len > buff->max_size) {
+		size_t max_size = buff->max_size ? buff->max_size : 256;
+		while (max_size < buff->size + len)
+			max_size *= 2;
+		buff->buff = (char *)realloc(buff->buff, max_size);
+		DIE(buff->buff == NULL, "realloc() failed\n");
+		buff->max_size = max_size;
+	}
+
+	memcpy(buff->buff + buff->size, data, len);
+	buff->size += len;
+}
+
+// Append some bytes in the output buffer.
+static void output_append(const char *data, size_t len)
+{
+	if (capture_buff) {
+		output_capture_append(data, len);
+		return;
+	}
+
+	// Make place in buffer.
+	if (out.size + len > out.max_size)
+		output_flush();
+
+	// The big blocks are written directly.
+	if (len > out.max_size) {
+		output_write_all(data, len);
+		return;
+	}
+
+	memcpy(out.buff + out.size, data, len);
+	out.size += len;
+}
+
+// Write in buff the decimal representation of a number and return
+// its length. (buff must have at least 11 bytes.)
+static size_t output_format_int(char *buff, int number)
+{
+	char digits[10];
+	size_t len = 0, n_digits = 0;
+	unsigned int value = (unsigned int)number;
+
+	if (number < 0) {
+		buff[len++] = '-';
+		value = 0u - value;
+	}
+
+	do {
+		digits[n_digits++] = (char)('0' + value % 10);
+		value /= 10;
+	} while (value);
+
+	while (n_digits)
+		buff[len++] = digits[--n_digits];
+
+	return len;
+}
+
+void output_open(int fd, output_format_t format)
+{
+	// Allocate the buffer just once.
+	if (!out.buff) {
+		out.buff = (char *)malloc(OUTPUT_BUFFER_SIZE);
+		DIE(out.buff == NULL, "malloc() failed\n");
+		out.max_size = OUTPUT_BUFFER_SIZE;
+	}
+
+	// Don't lose the responses if the program is stopped by DIE().
+	if (!registered) {
+		atexit(output_close);
+		registered = true;
+	}
+
+	output_flush();
+	out.fd = fd;
+	out.format = format;
+}
+
+void output_response_begin(int server_id, uint32_t response_len,
+						   const char *log)
+{
+	// Prepare the output stage if wasn't done.
+	if (!out.buff && !capture_buff)
+		output_open(STDOUT_FILENO, OUTPUT_TEXT);
+
+	if (out.format == OUTPUT_BINARY) {
+		uint32_t header[3];
+		header[0] = (uint32_t)server_id;
+		header[1] = response_len;
+		header[2] = (uint32_t)strlen(log);
+		output_append((const char *)header, sizeof(header));
+		return;
+	}
+
+	// GENERIC_MSG: "[Server %d]-Response: %s\n[Server %d]-Log: %s\n\n"
+	char id[16];
+	size_t id_len = output_format_int(id, server_id);
+	output_append("[Server ", 8);
+	output_append(id, id_len);
+	output_append("]-Response: ", 12);
+}
+
+void output_response_part(const char *data, size_t len)
+{
+	output_append(data, len);
+}
+
+void output_response_end(int server_id, const char *log)
+{
+	if (out.format == OUTPUT_BINARY) {
+		output_append(log, strlen(log));
+		return;
+	}
+
+	char id[16];
+	size_t id_len = output_format_int(id, server_id);
+	output_append("\n[Server ", 9);
+	output_append(id, id_len);
+	output_append("]-Log: ", 7);
+	output_append(log, strlen(log));
+	output_append("\n\n", 2);
+}
+
+void output_response(int server_id, const char *response, const char *log)
+{
+	// A missing response is written as "(null)" in text.
+	if (!response && out.format == OUTPUT_TEXT)
+		response = "(null)";
+	uint32_t len = response ? (uint32_t)strlen(response) : UINT32_MAX;
+
+	output_response_begin(server_id, len, log);
+	if (response)
+		output_response_part(response, len);
+	output_response_end(server_id, log);
+}
+
+void output_capture(output_t *capture)
+{
+	capture_buff = capture;
+}
+
+void output_write(const char *data, size_t len)
+{
+	if (!out.buff)
+		output_open(STDOUT_FILENO, OUTPUT_TEXT);
+	output_append(data, len);
+}
+
+void output_flush(void)
+{
+	output_write_all(out.buff, out.size);
+	out.size = 0;
+}
+
+void output_close(void)
+{
+	if (!out.buff)
+		return;
+
+	output_flush();
+	free(out.buff);
+	out.buff = NULL;
+	out.max_size = 0;
+}
@@ -0,0 +1,118 @@
+// Copyright Necula Mihail 313CAa 2023-2024
+#ifndef OUTPUT_H
+#define OUTPUT_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* The size of the buffer in which the responses are gathered. */
+#define OUTPUT_BUFFER_SIZE	(1 << 20)
+
+/******************************
+ * The formats in which the responses can be written.
+*******************************/
+typedef enum output_format_t {
+	/* GENERIC_MSG, like printf() would write it. */
+	OUTPUT_TEXT,
+	/* For every response, a record with 3 fields of type uint32_t
+	(server_id, length of the response, length of the log), followed
+	by the bytes of the response and of the log (without '\0').
+	A missing response has the length UINT32_MAX. */
+	OUTPUT_BINARY
+} output_format_t;
+
+/******************************
+ * The output stage: the responses are appended in a big buffer
+ * which is written with a single write() when it's full.
+ * The same structure is used to capture the responses of a worker
+ * thread (fd = -1): the buffer grows and is never written.
+*******************************/
+typedef struct output_t {
+	/* The file descriptor where are written the responses
+	(-1 for a capture buffer). */
+	int fd;
+	/* The format of the responses. */
+	output_format_t format;
+	/* The buffer. */
+	char *buff;
+	/* The number of bytes from buffer. */
+	size_t size;
+	/* The capacity of the buffer. */
+	size_t max_size;
+} output_t;
+
+/******************************
+ * output_open() - Prepare the output stage. The buffer is written
+ *		also when the program exits.
+ *
+ * @param fd: The file descriptor where the responses are written.
+ * @param format: The format of the responses.
+*******************************/
+void output_open(int fd, output_format_t format);
+
+/******************************
+ * output_response() - Append a response in the output buffer.
+ *		(The same as output_response_begin(), a single piece and
+ *		output_response_end().)
+ *
+ * @param server_id: The id of the server which gave the response.
+ * @param response: The response (NULL is written as "(null)").
+ * @param log: The log of the server.
+*******************************/
+void output_response(int server_id, const char *response, const char *log);
+
+/******************************
+ * output_response_begin() - Start a response whose content is written
+ *		in more pieces (see output_response_part()), so it doesn't have
+ *		to be put together before.
+ *
+ * @param server_id: The id of the server which gave the response.
+ * @param response_len: The length of the response (the sum of the
+ *		lengths of the pieces).
+ * @param log: The log of the server.
+*******************************/
+void output_response_begin(int server_id, uint32_t response_len,
+						   const char *log);
+
+/******************************
+ * @brief Append a piece of the response which was started with
+ *		output_response_begin().
+*******************************/
+void output_response_part(const char *data, size_t len);
+
+/******************************
+ * @brief Finish a response which was started with
+ *		output_response_begin() (the same server_id and log).
+*******************************/
+void output_response_end(int server_id, const char *log);
+
+/******************************
+ * output_capture() - Redirect the responses of the current thread
+ *		in a capture buffer, instead of the output stage.
+ *
+ * @param capture: The capture buffer (fd = -1). NULL sends again
+ *		the responses in the output stage.
+*******************************/
+void output_capture(output_t *capture);
+
+/******************************
+ * output_write() - Append in the output stage some responses which
+ *		were already formatted (the content of a capture buffer).
+ *
+ * @param data: The bytes.
+ * @param len: The number of bytes.
+*******************************/
+void output_write(const char *data, size_t len);
+
+/******************************
+ * @brief Write all the bytes from the output buffer.
+*******************************/
+void output_flush(void);
+
+/******************************
+ * @brief Write the remaining responses and free the output buffer.
+*******************************/
+void output_close(void);
+
+#endif
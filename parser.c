@@ -0,0 +1,315 @@
+// Copyright Necula Mihail 313CAa 2023-2024
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "parser.h"
+#include "trace.h"
+#include "load_balancer.h"
+#include "utils.h"
+
+// Read all the file in a buffer. (Used when the file can't be mapped.)
+static void parser_read_file(parser_t *p, int fd)
+{
+	size_t max_size = 1 << 16;
+	p->data = (char *)malloc(max_size);
+	DIE(p->data == NULL, "malloc() failed\n");
+	p->size = 0;
+
+	while (1) {
+		// Make place in buffer.
+		if (p->size == max_size) {
+			max_size *= 2;
+			p->data = (char *)realloc(p->data, max_size);
+			DIE(p->data == NULL, "realloc() failed\n");
+		}
+
+		ssize_t bytes = read(fd, p->data + p->size, max_size - p->size);
+		if (bytes < 0 && errno == EINTR)
+			continue;
+		DIE(bytes < 0, "read() failed");
+		if (!bytes)
+			break;
+		p->size += (size_t)bytes;
+	}
+}
+
+// Return the position of the end of the current line.
+static size_t parser_line_end(parser_t *p, size_t pos)
+{
+	char *end = (char *)memchr(p->data + pos, '\n', p->size - pos);
+	return end ? (size_t)(end - p->data) : p->size;
+}
+
+// Read a number (like atoi()) from [*pos, end) and update *pos.
+static int parser_number(parser_t *p, size_t *pos, size_t end)
+{
+	size_t i = *pos;
+	int sign = 1;
+	unsigned int number = 0;
+
+	// Skip the spaces.
+	while (i < end && (p->data[i] == ' ' || p->data[i] == '\t'))
+		++i;
+
+	if (i < end && (p->data[i] == '-' || p->data[i] == '+'))
+		sign = (p->data[i++] == '-') ? -1 : 1;
+
+	while (i < end && p->data[i] >= '0' && p->data[i] <= '9')
+		number = number * 10 + (unsigned int)(p->data[i++] - '0');
+
+	// The big ids wrap around (as the ids of the servers are unsigned).
+	*pos = i;
+	return (int)(sign < 0 ? 0u - number : number);
+}
+
+// Verify if there is a number in [pos, end).
+static bool parser_has_number(parser_t *p, size_t pos, size_t end)
+{
+	while (pos < end && (p->data[pos] == ' ' || p->data[pos] == '\t'))
+		++pos;
+	return pos < end && ((p->data[pos] >= '0' && p->data[pos] <= '9') ||
+						 p->data[pos] == '-' || p->data[pos] == '+');
+}
+
+// Verify if the input from pos starts with the given word.
+static bool parser_starts_with(parser_t *p, size_t pos, const char *word)
+{
+	size_t len = strlen(word);
+	return p->size - pos >= len && !memcmp(p->data + pos, word, len);
+}
+
+// Read a number from a binary trace and update *pos.
+static uint32_t parser_u32(parser_t *p, size_t *pos)
+{
+	uint32_t number;
+	DIE(p->end - *pos < sizeof(number), "truncated binary trace");
+	memcpy(&number, p->data + *pos, sizeof(number));
+	*pos += sizeof(number);
+	return number;
+}
+
+// Prepare a binary trace to be read: find the names of the docs.
+static void parser_open_binary(parser_t *p)
+{
+	trace_header_t header;
+	memcpy(&header, p->data, sizeof(header));
+	DIE(header.version != TRACE_VERSION, "unknown binary trace version");
+	DIE(header.names_offset < sizeof(header) ||
+		header.names_offset > p->size, "corrupted binary trace");
+
+	p->binary = true;
+	p->pos = sizeof(header);
+	p->names_count = header.names_count;
+	p->names = (char **)malloc((header.names_count + 1) * sizeof(char *));
+	DIE(p->names == NULL, "malloc() failed\n");
+
+	// The names are after the requests: length, bytes, '\0'.
+	size_t pos = (size_t)header.names_offset;
+	p->end = p->size;
+	for (uint32_t i = 0; i < header.names_count; ++i) {
+		uint32_t len = parser_u32(p, &pos);
+		DIE(p->size - pos < (size_t)len + 1, "truncated binary trace");
+		p->names[i] = p->data + pos;
+		pos += (size_t)len + 1;
+	}
+
+	// The requests end where the names start.
+	p->end = (size_t)header.names_offset;
+}
+
+// Read the next request from a binary trace.
+static void parser_next_binary(parser_t *p, parsed_request_t *req)
+{
+	DIE(p->pos >= p->end, "insufficient requests");
+
+	size_t pos = p->pos;
+	uint8_t type = (uint8_t)p->data[pos++];
+	DIE(type > REMOVE_SERVER, "unknown request type");
+	req->type = (request_type)type;
+	req->doc_name = NULL;
+	req->doc_id = -1;
+	req->doc_content = NULL;
+
+	if (req->type == ADD_SERVER) {
+		req->server_id = (int)parser_u32(p, &pos);
+		req->cache_size = (int)parser_u32(p, &pos);
+		req->weight = (int)parser_u32(p, &pos);
+	} else if (req->type == REMOVE_SERVER) {
+		req->server_id = (int)parser_u32(p, &pos);
+	} else {
+		uint32_t name_id = parser_u32(p, &pos);
+		DIE(name_id >= p->names_count, "corrupted binary trace");
+		req->doc_name = p->names[name_id];
+		req->doc_id = (int)name_id;
+
+		if (req->type == EDIT_DOCUMENT) {
+			uint32_t len = parser_u32(p, &pos);
+			DIE(p->end - pos < (size_t)len + 1, "truncated binary trace");
+			req->doc_content = p->data + pos;
+			pos += (size_t)len + 1;
+		}
+	}
+
+	p->pos = pos;
+}
+
+// Find the next quoted string from pos, put '\0' instead of its
+// closing quote and return it. *pos becomes the position after it.
+static char *parser_quoted_string(parser_t *p, size_t *pos)
+{
+	char *start = (char *)memchr(p->data + *pos, '"', p->size - *pos);
+	DIE(start == NULL, "document name / content is not properly quoted");
+	++start;
+
+	char *end = (char *)memchr(start, '"', p->data + p->size - start);
+	DIE(end == NULL, "document content is not properly quoted");
+	*end = '\0';
+
+	*pos = (size_t)(end - p->data) + 1;
+	return start;
+}
+
+parser_t *parser_open(const char *path)
+{
+	// Allocate memory for the parser's structure.
+	parser_t *p = (parser_t *)malloc(sizeof(parser_t));
+	DIE(p == NULL, "malloc() failed\n");
+	p->pos = 0;
+
+	// Open the file.
+	int fd = open(path, O_RDONLY);
+	DIE(fd < 0, "missing input file");
+
+	// Map the file privately. The writes (the '\0' put after the strings)
+	// aren't seen in the file.
+	struct stat st;
+	p->mapped = false;
+	if (!fstat(fd, &st) && S_ISREG(st.st_mode) && st.st_size > 0) {
+		p->size = (size_t)st.st_size;
+		p->data = (char *)mmap(NULL, p->size, PROT_READ | PROT_WRITE,
+							   MAP_PRIVATE, fd, 0);
+		if (p->data != MAP_FAILED) {
+			madvise(p->data, p->size, MADV_SEQUENTIAL);
+			p->mapped = true;
+		}
+	}
+
+	// If the file can't be mapped, read it.
+	if (!p->mapped)
+		parser_read_file(p, fd);
+
+	close(fd);
+	DIE(p->size == 0, "empty input file");
+
+	// Verify if the input is a binary trace.
+	p->binary = false;
+	p->end = p->size;
+	p->names = NULL;
+	p->names_count = 0;
+	if (p->size >= sizeof(trace_header_t) &&
+		!memcmp(p->data, TRACE_MAGIC, strlen(TRACE_MAGIC)))
+		parser_open_binary(p);
+
+	// Return the created parser.
+	return p;
+}
+
+void parser_read_header(parser_t *p, int *requests_num,
+						unsigned int *replicas)
+{
+	// The header of a binary trace was already verified.
+	if (p->binary) {
+		trace_header_t header;
+		memcpy(&header, p->data, sizeof(header));
+		*requests_num = (int)header.requests_num;
+		*replicas = header.replicas ? header.replicas : 1;
+		return;
+	}
+
+	size_t end = parser_line_end(p, p->pos);
+
+	// The number of requests.
+	size_t pos = p->pos;
+	*requests_num = parser_number(p, &pos, end);
+
+	// "ENABLE_VNODES [count]" - the number of replicas is optional.
+	*replicas = 1;
+	for (; pos < end; ++pos) {
+		if (!parser_starts_with(p, pos, ENABLE_VNODES_OPTION))
+			continue;
+
+		pos += strlen(ENABLE_VNODES_OPTION);
+		int count = parser_number(p, &pos, end);
+		*replicas = count > 0 ? (unsigned int)count : DEFAULT_REPLICAS;
+		break;
+	}
+
+	// Go to the next line.
+	p->pos = end < p->size ? end + 1 : end;
+}
+
+void parser_next_request(parser_t *p, parsed_request_t *req)
+{
+	if (p->binary) {
+		parser_next_binary(p, req);
+		return;
+	}
+
+	DIE(p->pos >= p->size, "insufficient requests");
+
+	size_t pos = p->pos;
+	size_t end = parser_line_end(p, pos);
+
+	// Find the type of the request.
+	if (parser_starts_with(p, pos, ADD_SERVER_REQUEST))
+		req->type = ADD_SERVER;
+	else if (parser_starts_with(p, pos, REMOVE_SERVER_REQUEST))
+		req->type = REMOVE_SERVER;
+	else if (parser_starts_with(p, pos, EDIT_REQUEST))
+		req->type = EDIT_DOCUMENT;
+	else if (parser_starts_with(p, pos, GET_REQUEST))
+		req->type = GET_DOCUMENT;
+	else
+		DIE(1, "unknown request type");
+
+	req->doc_name = NULL;
+	req->doc_id = -1;
+	req->doc_content = NULL;
+
+	if (req->type == ADD_SERVER) {
+		// "ADD_SERVER <id> <cache_size> [weight]"
+		pos += strlen(ADD_SERVER_REQUEST);
+		req->server_id = parser_number(p, &pos, end);
+		req->cache_size = parser_number(p, &pos, end);
+		req->weight = parser_has_number(p, pos, end) ?
+					  parser_number(p, &pos, end) : 1;
+	} else if (req->type == REMOVE_SERVER) {
+		// "REMOVE_SERVER <id>"
+		pos += strlen(REMOVE_SERVER_REQUEST);
+		req->server_id = parser_number(p, &pos, end);
+	} else {
+		// "GET "<name>"" or "EDIT "<name>" "<content>"". The content
+		// can have more lines, so the end of the request is found
+		// after the closing quote.
+		req->doc_name = parser_quoted_string(p, &pos);
+		if (req->type == EDIT_DOCUMENT)
+			req->doc_content = parser_quoted_string(p, &pos);
+		end = parser_line_end(p, pos);
+	}
+
+	// Go to the next line.
+	p->pos = end < p->size ? end + 1 : end;
+}
+
+void parser_close(parser_t **p)
+{
+	if ((*p)->mapped)
+		munmap((*p)->data, (*p)->size);
+	else
+		free((*p)->data);
+
+	free((*p)->names);
+	free(*p);
+	*p = NULL;
+}
@@ -0,0 +1,95 @@
+// Copyright Necula Mihail 313CAa 2023-2024
+#ifndef PARSER_H
+#define PARSER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "constants.h"
+
+/******************************
+ * The parser maps the input file in memory (privately, so the file
+ * isn't modified) and splits it in place: the quote which ends a
+ * name or a content is replaced with '\0' and the request receives
+ * pointers in the mapping. So, the strings are never copied.
+ * The binary traces (see trace.h) are recognized after their first
+ * bytes and are read from the same mapping.
+*******************************/
+typedef struct parser_t {
+	/* The content of the input file. */
+	char *data;
+	/* The size of the input file. */
+	size_t size;
+	/* The position from where the next request is read. */
+	size_t pos;
+	/* true  -> data was mapped with mmap()
+	   false -> data was read in a buffer (the file can't be mapped) */
+	bool mapped;
+	/* true -> the input is a binary trace */
+	bool binary;
+	/* The position where the requests of a binary trace end. */
+	size_t end;
+	/* The names of the docs from a binary trace (point in data). */
+	char **names;
+	/* The number of names from a binary trace. */
+	uint32_t names_count;
+} parser_t;
+
+/******************************
+ * The arguments of a request which was read.
+*******************************/
+typedef struct parsed_request_t {
+	/* The type of the request. */
+	request_type type;
+	/* The id of the server (ADD_SERVER, REMOVE_SERVER). */
+	int server_id;
+	/* The size of the cache (ADD_SERVER). */
+	int cache_size;
+	/* The weight of the server (ADD_SERVER, 1 if it's missing). */
+	int weight;
+	/* The name of the doc (EDIT, GET) - points in the input. */
+	char *doc_name;
+	/* The id of the name in a binary trace (-1 for a text trace). */
+	int doc_id;
+	/* The content of the doc (EDIT) - points in the input. */
+	char *doc_content;
+} parsed_request_t;
+
+/******************************
+ * parser_open() - Open an input file (a text or a binary trace)
+ *		and prepare it to be parsed.
+ *
+ * @param path: The path of the file.
+ *
+ * @return - The created parser.
+*******************************/
+parser_t *parser_open(const char *path);
+
+/******************************
+ * parser_read_header() - Read the first line of the input:
+ *		"<requests_num> [ENABLE_VNODES [count]]" (or the header
+ *		of a binary trace).
+ *
+ * @param p: The parser.
+ * @param requests_num: Returns the number of requests.
+ * @param replicas: Returns the number of replicas of a server.
+*******************************/
+void parser_read_header(parser_t *p, int *requests_num,
+						unsigned int *replicas);
+
+/******************************
+ * parser_next_request() - Read the next request. The quoted strings
+ *		are found with memchr().
+ *
+ * @param p: The parser.
+ * @param req: Returns the arguments of the request.
+*******************************/
+void parser_next_request(parser_t *p, parsed_request_t *req);
+
+/******************************
+ * @brief Unmap the input file and free the memory of the parser.
+ *		The strings given by the parser can't be used anymore.
+*******************************/
+void parser_close(parser_t **p);
+
+#endif
@@ -1,19 +1,49 @@
 // Copyright Necula Mihail 313CAa 2023-2024
 #include "queue.h"
 
-queue_t * q_create(u_int data_size, u_int max_size, void (*free_elem)(void *))
+// Find the smallest power of 2 which isn't smaller than n.
+static size_t q_round_up(size_t n)
+{
+	size_t power = 1;
+	while (power < n)
+		power *= 2;
+	return power;
+}
+
+// Double the capacity of a queue. The elements are put from the
+// start of the new array, in their order.
+static void q_grow(queue_t *q)
+{
+	void **buff = (void **)malloc(2 * q->max_size * sizeof(void *));
+	DIE(buff == NULL, "malloc() failed\n");
+
+	// The elements from read_idx to the end of array and then the ones
+	// from the start of array.
+	u_int first = q->max_size - q->read_idx;
+	if (first > q->size)
+		first = q->size;
+	memcpy(buff, q->buff + q->read_idx, first * sizeof(void *));
+	memcpy(buff + first, q->buff, (q->size - first) * sizeof(void *));
+
+	free(q->buff);
+	q->buff = buff;
+	q->max_size *= 2;
+	q->read_idx = 0;
+	q->write_idx = q->size;
+}
+
+queue_t * q_create(u_int max_size, void (*free_elem)(void *))
 {
 	// Create the queque.
 	queue_t *q = (queue_t *)malloc(sizeof(queue_t));
 	DIE(q == NULL, "malloc() failed\n");
 
 	// Initialize the fields of queue.
-	q->max_size = max_size;
+	q->max_size = (u_int)q_round_up(max_size ? max_size : 1);
 	q->size = 0;
-	q->data_size = data_size;
 	q->read_idx = 0;
 	q->write_idx = 0;
-	q->buff = malloc(max_size * sizeof(void *));
+	q->buff = malloc(q->max_size * sizeof(void *));
 	DIE(q->buff == NULL, "malloc() failed\n");
 	q->free_elem = free_elem;
 
@@ -59,7 +89,7 @@ u_int q_dequeue(queue_t *q)
 	}
 
 	// Update the queue's parameters.
-	q->read_idx = (q->read_idx + 1) % q->max_size;
+	q->read_idx = (q->read_idx + 1) & (q->max_size - 1);
 	q->size--;
 
 
@@ -70,14 +100,18 @@ u_int q_dequeue(queue_t *q)
 u_int q_enqueue(queue_t *q, void *new_data)
 {
 	// Verify the parameter of the function.
-	if (!q || q->size == q->max_size)
+	if (!q)
 		return 0;
 
-	// Make a coppy of the given data and put it in queue.
-	memcpy(&q->buff[q->write_idx], new_data, q->data_size);
+	// Make place for the new element.
+	if (q->size == q->max_size)
+		q_grow(q);
+
+	// Put the element in queue.
+	q->buff[q->write_idx] = new_data;
 
 	// Update queue's parameters.
-	q->write_idx = (q->write_idx + 1) % q->max_size;
+	q->write_idx = (q->write_idx + 1) & (q->max_size - 1);
 	q->size++;
 
 	// The operation was done succesfully.
@@ -113,3 +147,89 @@ void q_free(queue_t *q)
 	// Free the queue structure's memory.
 	free(q);
 }
+
+lf_queue_t *lfq_create(size_t max_size)
+{
+	// Create the queue.
+	lf_queue_t *q = (lf_queue_t *)aligned_alloc(CACHE_LINE_SIZE,
+												sizeof(lf_queue_t));
+	DIE(q == NULL, "aligned_alloc() failed\n");
+
+	// Every cell waits to be written at its own position.
+	max_size = q_round_up(max_size ? max_size : 1);
+	q->cells = (lf_cell_t *)malloc(max_size * sizeof(lf_cell_t));
+	DIE(q->cells == NULL, "malloc() failed\n");
+	for (size_t i = 0; i < max_size; ++i)
+		atomic_init(&q->cells[i].seq, i);
+	q->mask = max_size - 1;
+	atomic_init(&q->enqueue_pos, 0);
+	atomic_init(&q->dequeue_pos, 0);
+
+	// Return the queue.
+	return q;
+}
+
+bool lfq_push(lf_queue_t *q, void *data)
+{
+	size_t pos = atomic_load_explicit(&q->enqueue_pos, memory_order_relaxed);
+
+	while (1) {
+		lf_cell_t *cell = &q->cells[pos & q->mask];
+		size_t seq = atomic_load_explicit(&cell->seq, memory_order_acquire);
+		intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+
+		if (diff == 0) {
+			// The cell is free; try to reserve it.
+			if (atomic_compare_exchange_weak_explicit(&q->enqueue_pos, &pos,
+					pos + 1, memory_order_relaxed, memory_order_relaxed)) {
+				cell->data = data;
+				atomic_store_explicit(&cell->seq, pos + 1,
+									  memory_order_release);
+				return true;
+			}
+		} else if (diff < 0) {
+			// The cell wasn't read since the last round -> full queue.
+			return false;
+		} else {
+			// Other producer took the position.
+			pos = atomic_load_explicit(&q->enqueue_pos, memory_order_relaxed);
+		}
+	}
+}
+
+void *lfq_pop(lf_queue_t *q)
+{
+	size_t pos = atomic_load_explicit(&q->dequeue_pos, memory_order_relaxed);
+
+	while (1) {
+		lf_cell_t *cell = &q->cells[pos & q->mask];
+		size_t seq = atomic_load_explicit(&cell->seq, memory_order_acquire);
+		intptr_t diff = (intptr_t)seq - (intptr_t)(pos + 1);
+
+		if (diff == 0) {
+			// The cell was written; try to take it.
+			if (atomic_compare_exchange_weak_explicit(&q->dequeue_pos, &pos,
+					pos + 1, memory_order_relaxed, memory_order_relaxed)) {
+				void *data = cell->data;
+				// The cell can be written again in the next round.
+				atomic_store_explicit(&cell->seq, pos + q->mask + 1,
+									  memory_order_release);
+				return data;
+			}
+		} else if (diff < 0) {
+			// Empty queue.
+			return NULL;
+		} else {
+			pos = atomic_load_explicit(&q->dequeue_pos, memory_order_relaxed);
+		}
+	}
+}
+
+void lfq_free(lf_queue_t *q)
+{
+	if (!q)
+		return;
+
+	free(q->cells);
+	free(q);
+}
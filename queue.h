@@ -5,19 +5,27 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
 #include "utils.h"
 
+/* The size of a cache line, used to keep apart the indexes written
+by different threads. */
+#define CACHE_LINE_SIZE		64
+
 /******************************
- * The queue is implemented using an array of pointers.
+ * The queue is implemented using an array of pointers, whose size is
+ * a power of 2 (so the indexes wrap with a mask). When the array is
+ * full, its size is doubled, so an element is never dropped.
 *******************************/
 typedef struct queue_t
 {
-	/* The maximum number of elements which can be stored in queue. */
+	/* The number of elements which can be stored before the array
+	is doubled (a power of 2). */
 	u_int max_size;
 	/* The current number of elements from the queue. */
 	u_int size;
-	/* The dimension, in bytes, of an element. */
-	u_int data_size;
 	/* The index from where will take place the operations
 	of front and dequeue. */
 	u_int read_idx;
@@ -30,17 +38,44 @@ typedef struct queue_t
 	void (*free_elem)(void *);
 }queue_t;
 
+/******************************
+ * A cell of a lock-free queue. Its sequence number says if the cell
+ * can be written (seq == position) or read (seq == position + 1).
+*******************************/
+typedef struct lf_cell_t
+{
+	atomic_size_t seq;
+	void *data;
+} lf_cell_t;
+
+/******************************
+ * A bounded lock-free queue of pointers, in which more threads can put
+ * elements in the same time. When it's full, lfq_push() fails, so the
+ * producer knows that it must wait (backpressure).
+*******************************/
+typedef struct lf_queue_t
+{
+	/* The cells (their number is a power of 2). */
+	lf_cell_t *cells;
+	/* The number of cells - 1. */
+	size_t mask;
+	/* The position where will be put the next element. */
+	_Alignas(CACHE_LINE_SIZE) atomic_size_t enqueue_pos;
+	/* The position from where will be taken the next element. */
+	_Alignas(CACHE_LINE_SIZE) atomic_size_t dequeue_pos;
+} lf_queue_t;
+
 /******************************
  * q_create() - Create and initialize a queue.
  *
- * @param data_size: The size / number of bytes of an element.
- * @param max_size: Maximum number of elements which can be stored.
+ * @param max_size: The initial capacity (rounded up to a power of 2).
+ *		The queue grows when more elements are put in it.
  * @param free_elemen: Pointer to the function which free the memory
  * 		allocated for an element.
  *
  * @return - The created queue.
 *******************************/
-queue_t *q_create(u_int data_size, u_int max_size, void (*free_elem)(void *));
+queue_t *q_create(u_int max_size, void (*free_elem)(void *));
 
 /******************************
  * @return - The number of elements from the given queue.
@@ -74,10 +109,11 @@ void *q_front(queue_t *q);
 u_int q_dequeue(queue_t *q);
 
 /******************************
- * q_enqueue() - Introduce a new element in a queue. 
+ * q_enqueue() - Introduce a new element in a queue. If the queue
+ *		is full, its capacity is doubled.
  * 
  * @param q: The queue with which we work.
- * @param new_data: The new element.
+ * @param new_data: The new element (the pointer is stored).
  *
  * @return 1, if the operation was done succesfuly
  *		   0, in contrary case
@@ -96,5 +132,41 @@ void q_clear(queue_t *q);
 *******************************/
 void q_free(queue_t *q);
 
+/******************************
+ * lfq_create() - Create a lock-free queue.
+ *
+ * @param max_size: The capacity (rounded up to a power of 2).
+ *
+ * @return - The created queue.
+*******************************/
+lf_queue_t *lfq_create(size_t max_size);
+
+/******************************
+ * lfq_push() - Put an element in a lock-free queue. It can be called
+ *		by more threads in the same time.
+ *
+ * @param q: The queue with which we work.
+ * @param data: The new element.
+ *
+ * @return true, if the element was put
+ *		   false, if the queue is full (the producer must wait)
+*******************************/
+bool lfq_push(lf_queue_t *q, void *data);
+
+/******************************
+ * lfq_pop() - Take out the first element from a lock-free queue.
+ *
+ * @param q: The queue with which we work.
+ *
+ * @return - The element or NULL, if the queue is empty.
+*******************************/
+void *lfq_pop(lf_queue_t *q);
+
+/******************************
+ * @brief Free the memory allocated for the given lock-free queue
+ *		(not for its elements).
+*******************************/
+void lfq_free(lf_queue_t *q);
+
 #endif
 
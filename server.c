@@ -1,4 +1,5 @@
 // Copyright Necula Mihail 313CAa 2023-2024
+#include <time.h>
 #include "server.h"
 
 void free_request(void *r)
@@ -6,150 +7,242 @@ void free_request(void *r)
 	// Make the needed cast.
 	request_t *req = (request_t *)r;
 
-	// Free the memory.
-	free(req->doc_name);
-	free(req->doc_content);
-	free(req);
+	// Give back the content and the memory to the pool. (The name
+	// is interned.)
+	blob_put(req->content);
+	pool_free(req);
 }
 
-void key_doc_free_function(void *data)
+void free_doc(void *d)
 {
 	// Make the needed cast.
-	info_t *pair = (info_t *)data;
+	doc_t *file = (doc_t *)d;
 
-	// Free the key's memory
-	free(pair->key);
-
-	// Free the value's memory.
-	doc_t *file = *(doc_t **)pair->value;
-	free(file->name);
-	free(file->content);
-	free(file);
-	free(pair->value);
+	// Give back the content and the memory to the pool. (The name
+	// is interned.)
+	blob_put(file->content);
+	pool_free(file);
 }
 
 request_t *duplicate_request(request_t *req)
 {
 	// Create a request
-	request_t *req_dup = (request_t *)malloc(sizeof(request_t));
-	DIE(req_dup == NULL, "malloc() failed\n");
+	request_t *req_dup = (request_t *)pool_alloc(sizeof(request_t));
 
-	// Coppy the type.
+	// Coppy the type and the doc's name (which is interned, so
+	// it's shared).
 	req_dup->type = req->type;
+	req_dup->doc_name = req->doc_name;
+	req_dup->creates_doc = req->creates_doc;
 
-	// Coppy the doc's name.
-	req_dup->doc_name = (char *)malloc(strlen(req->doc_name) + 1);
-	strcpy(req_dup->doc_name, req->doc_name);
-
-	// Coppy the doc's contents.
-	req_dup->doc_content = (char *)malloc(strlen(req->doc_content) + 1);
-	strcpy(req_dup->doc_content, req->doc_content);
+	// The content isn't copied: it's put in a blob, which will be
+	// shared with the doc.
+	req_dup->doc_content = req->doc_content;
+	req_dup->content = blob_wrap(req->doc_content);
 
 	// Return the duplicate.
 	return req_dup;
 }
 
-response_t *create_response()
+response_t *create_response(size_t log_len, size_t response_len)
 {
-	// Alocate memory for reponse's structure.
-	response_t *rsp = (response_t *)malloc(sizeof(response_t));
-	DIE(rsp == NULL, "malloc() failed\n");
-
-	// Allocate memory for the server's log.
-	rsp->server_log = (char *)malloc(MAX_LOG_LENGTH * sizeof(char));
-	DIE(rsp->server_log== NULL, "malloc() failed\n");
+	// Alocate memory for reponse's structure and for its messages.
+	response_t *rsp = (response_t *)pool_alloc(sizeof(response_t) +
+											   log_len + response_len);
 
-	// Allocate memory for the server's reponse.
-	rsp->server_response = (char *)malloc(MAX_RESPONSE_LENGTH * sizeof(char));
-	DIE(rsp->server_response == NULL, "malloc() failed\n");
+	// The messages are written in the buffer after the structure.
+	rsp->server_log = rsp->buff;
+	rsp->server_response = rsp->buff + log_len;
+	rsp->content = NULL;
 
 	// Return the created response.
 	return rsp;
 }
 
-doc_t *init_doc(char *doc_name, char *doc_content)
+void free_response(response_t *rsp)
 {
-	// Allocate memory for doc's structure.
-	doc_t *file = (doc_t *)malloc(sizeof(doc_t));
-	DIE(file == NULL, "malloc() failed\n");
+	// The fields point in the structure or at the content of
+	// a doc, so just the reference to the content must be given
+	// back and the structure must be freed.
+	blob_put(rsp->content);
+	pool_free(rsp);
+}
 
-	// Allocate memory for doc's name and init that field.
-	file->name = (char *)malloc((strlen(doc_name) + 1) * sizeof(char));
-	DIE(file->name == NULL, "malloc() failed\n");
-	strcpy(file->name, doc_name);
+void write_response(response_t *rsp)
+{
+	if (!rsp->content) {
+		output_response(rsp->server_id, rsp->server_response,
+						rsp->server_log);
+		return;
+	}
 
-	// Allocate memory dor doc's content and init that field.
-	file->content = (char *)malloc((strlen(doc_content) + 1) * sizeof(char));
-	DIE(file->content == NULL, "malloc() failed\n");
-	strcpy(file->content, doc_content);
+	// The content of a doc isn't copied in a single string.
+	output_response_begin(rsp->server_id, blob_size(rsp->content),
+						  rsp->server_log);
+	blob_output(rsp->content);
+	output_response_end(rsp->server_id, rsp->server_log);
+}
 
-	// Return the created file.
-	return file;
+void doc_set_content(doc_t *file, blob_t *content)
+{
+	// Take the new content before to give back the old one (they
+	// could be the same).
+	blob_get(content);
+	blob_put(file->content);
+	file->content = content;
 }
 
-hashtable_t *db_redistribute_docs(hashtable_t *old_db, int new_hmax)
+void server_compress_doc(server_t *s, doc_t *file)
 {
-	// Create the new databse.
-	hashtable_t *new_db = ht_create(new_hmax, old_db->hash_function,
-						  old_db->compare_function,
-						  old_db->key_val_free_function);
-
-	// Add every doc from the old db in the new db.
-	for (u_int i = 0; i < old_db->hmax; ++i) {
-		// Get a bucket from the old ht.
-		ll_t *curr_list = old_db->buckets[i];
-
-		// Go through bucket.
-		ll_node_t *curr_node = curr_list->head;
-		while (curr_node) {
-			info_t *pair = (info_t *)curr_node->data;
-			char *doc_name = (char *)pair->key;
-			ht_put(new_db, doc_name, strlen(doc_name) + 1, pair->value,
-				   sizeof(doc_t *));
-			curr_node = curr_node->next;
-
-			free(pair->key);
-			free(pair->value);
-		}
+	if (!s->compress)
+		return;
+
+	// The doc keeps the old content if it can't be compressed.
+	blob_t *packed = blob_pack(file->content);
+	if (!packed)
+		return;
+
+	// Count the compression.
+	server_stats_t *stats = &s->mom->stats;
+	stats->packed_docs++;
+	stats->raw_bytes += packed->size;
+	stats->packed_bytes += packed->packed_size;
+
+	// Give the compressed content to the doc. (A response can still
+	// have the old one.)
+	doc_set_content(file, packed);
+	blob_put(packed);
+}
 
-		// Deallocate the memory of the bucket.
-		ll_free(&curr_list);
-	}
+// Decompress the content of a doc, if it's compressed.
+static void server_unpack_doc(server_t *s, doc_t *file)
+{
+	if (!file->content->packed_size)
+		return;
+
+	// Measure the time of the decompression.
+	struct timespec start, end;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	blob_t *unpacked = blob_unpack(file->content);
+	clock_gettime(CLOCK_MONOTONIC, &end);
+
+	// Count the decompression.
+	server_stats_t *stats = &s->mom->stats;
+	stats->unpacked_docs++;
+	stats->unpack_ns += (uint64_t)(end.tv_sec - start.tv_sec) * 1000000000 +
+						(uint64_t)end.tv_nsec - (uint64_t)start.tv_nsec;
+
+	// Give the decompressed content to the doc.
+	doc_set_content(file, unpacked);
+	blob_put(unpacked);
+}
+
+void server_stats_add(server_stats_t *dst, const server_stats_t *src)
+{
+	dst->packed_docs += src->packed_docs;
+	dst->raw_bytes += src->raw_bytes;
+	dst->packed_bytes += src->packed_bytes;
+	dst->unpacked_docs += src->unpacked_docs;
+	dst->unpack_ns += src->unpack_ns;
+}
 
-	// Free the unncesary memory.
-	free(old_db->buckets);
-	free(old_db);
+doc_t *init_doc(doc_name_t *doc_name, blob_t *content)
+{
+	// Allocate memory for doc's structure.
+	doc_t *file = (doc_t *)pool_alloc(sizeof(doc_t));
+
+	// The name is interned, so it isn't copied.
+	file->name = doc_name;
+
+	// Share the content (it isn't copied).
+	file->content = blob_get(content);
+
+	// Initialize the fields used by the index.
+	file->hash = doc_name->hash;
+	file->idx_left = NULL;
+	file->idx_right = NULL;
+	file->idx_priority = (u_int)rand();
 
-	// Return the new created ht / database.
-	return new_db;
+	// The doc isn't in cache yet.
+	file->lru_prev = NULL;
+	file->lru_next = NULL;
+
+	// Return the created file.
+	return file;
 }
 
-hashtable_t *db_increase_hmax(hashtable_t *db)
+bool db_add_doc(server_t *s, doc_t *file)
 {
-	u_int prime_number[9] = {17, 173, 1733, 17383, 173839, 1738391,
-							17383913, 173839157, 1738391579};
+	// If there is an older version of the document, the new version
+	// takes its entry (the table grows only when the doc is new).
+	flat_entry_t *entry = flat_table_find(s->local_db, file->name,
+										  file->hash);
+	bool replaced = entry != NULL;
+	if (replaced) {
+		// The new version takes the place of the old one in cache.
+		doc_t *old_file = (doc_t *)entry->value;
+		lru_cache_replace(s->cache, old_file, file);
+		doc_index_remove(s->doc_index, old_file);
+		entry->key = file->name;
+		entry->value = file;
+		free_doc(old_file);
+	} else {
+		// Add the document.
+		flat_table_put(s->local_db, file->name, file->hash, file);
+	}
+	doc_index_insert(s->doc_index, file);
 
-	for (int i = 0; i < 8; ++i)
-		if(prime_number[i] == db->hmax)
-			return db_redistribute_docs(db, prime_number[i + 1]);
+	return replaced;
+}
 
-	return db;
+void db_remove_doc(server_t *s, doc_name_t *doc_name)
+{
+	// Take out the document from the hashtable, if it's there.
+	doc_t *file = (doc_t *)flat_table_remove(s->local_db, doc_name,
+											 doc_name->hash);
+	if (!file)
+		return;
+
+	// Remove it from the cache and from the index.
+	lru_cache_remove(s->cache, file);
+	doc_index_remove(s->doc_index, file);
+	free_doc(file);
 }
 
-void db_add_doc(server_t *s, doc_t *file)
+doc_t *db_take_docs(server_t *s, u_int hash_lo, u_int hash_hi)
 {
-	// Verify if we need to add more buckets in the database's hashtable.
-	if ((*s->local_db)->size / 10 == (*s->local_db)->hmax)
-		*s->local_db = db_increase_hmax(*s->local_db);
+	// Take out the docs from the index.
+	doc_t *docs = doc_index_extract(s->doc_index, hash_lo, hash_hi);
+
+	// Take out the docs from the cache and from the hashtable, without
+	// to free them.
+	for (doc_t *file = docs; file; file = file->idx_right) {
+		lru_cache_remove(s->cache, file);
+		flat_table_remove(s->local_db, file->name, file->hash);
+	}
 
-	// Add the document.
-	char *name = file->name;
-	ht_put(*s->local_db, name, strlen(name) + 1, &file, sizeof(doc_t *));
+	// Return the docs.
+	return docs;
 }
 
-void db_remove_doc(server_t *s, char *doc_name)
+doc_t *db_write_doc(server_t *s, doc_name_t *doc_name, blob_t *content,
+					bool *replaced)
 {
-	ht_remove_entry(*s->local_db, doc_name);
+	// If the doc exists, just give it the new content. The database,
+	// the index and the cache keep pointing at it.
+	flat_entry_t *entry = flat_table_find(s->local_db, doc_name,
+										  doc_name->hash);
+	*replaced = entry != NULL;
+	if (entry) {
+		doc_t *file = (doc_t *)entry->value;
+		doc_set_content(file, content);
+		return file;
+	}
+
+	// Create the doc and add it in the database.
+	doc_t *file = init_doc(doc_name, content);
+	db_add_doc(s, file);
+	return file;
 }
 
 server_t *init_server(u_int server_id, u_int cache_size)
@@ -160,15 +253,21 @@ server_t *init_server(u_int server_id, u_int cache_size)
 
 	// Allocate memory for every complex field from structure.
 	srv->cache = init_lru_cache(cache_size);
-	srv->local_db = (hashtable_t **)malloc(sizeof(hashtable_t *));
-	DIE(srv->local_db == NULL, "malloc() failed\n");
-	*srv->local_db = ht_create(17, hash_string, compare_function_strings,
-					key_doc_free_function);
-	srv->task_queue = q_create(sizeof(request_t *), TASK_QUEUE_SIZE, free_request);
+	srv->local_db = flat_table_create(NULL);
+	srv->doc_index = doc_index_create();
+	srv->task_queue = q_create(TASK_QUEUE_SIZE, free_request);
+	srv->pending_edits = flat_table_create(NULL);
 
 	// Initialize the parameters of the server.
 	srv->id = server_id;
+	srv->replica_idx = 0;
 	srv->hash_id = 0;
+	srv->mom = srv;
+	srv->worker = -1;
+	srv->targeted_flush = false;
+	srv->unflushed_tasks = 0;
+	srv->compress = false;
+	memset(&srv->stats, 0, sizeof(srv->stats));
 
 	// Return the created server.
 	return srv;
@@ -178,11 +277,14 @@ void free_resources_of_server(server_t *srv)
 {
 	// Free the memory of the cache.
 	free_lru_cache(&srv->cache);
-	// Free the memory of the local data base.
-	ht_free(srv->local_db);
-	free(srv->local_db);
-	// Free the memory of the requests's queue.
+	// Free the memory of the local data base (and of its docs).
+	flat_table_for_each(srv->local_db, free_doc);
+	flat_table_free(&srv->local_db);
+	doc_index_free(&srv->doc_index);
+	// Free the memory of the requests's queue. (The pending edits
+	// point in it.)
 	q_free(srv->task_queue);
+	flat_table_free(&srv->pending_edits);
 }
 
 void free_server(server_t **s)
@@ -201,108 +303,171 @@ void free_server(server_t **s)
 	*s = NULL;
 }
 
-response_t *server_edit_document(server_t *s, char *doc_name, char *doc_content)
+// Make the response of a request which put a doc in cache. The log
+// says if the doc was in cache or which doc was evicted.
+static response_t *server_cache_response(server_t *s, doc_name_t *doc_name,
+										 bool hit, doc_t *evicted_doc,
+										 size_t response_len)
 {
-	// Do the response.
-	response_t *rsp = create_response();
-	if (lru_cache_has_key(s->cache, doc_name)) {
-		sprintf(rsp->server_log, LOG_HIT, doc_name);
-		sprintf(rsp->server_response, MSG_B, doc_name);
-	} else {
-		// Will update the log later if the cache is full
-		// and the curent doc isn't in cache.
-		sprintf(rsp->server_log, LOG_MISS, doc_name);
-		if (!ht_has_key(*s->local_db, doc_name)) {
-			sprintf(rsp->server_response, MSG_C, doc_name);
-		} else {
-			sprintf(rsp->server_response, MSG_B, doc_name);
-		}
-	}
+	// The log has the names of the docs, so it's as long as them.
+	u_int evicted_len = evicted_doc ? evicted_doc->name->len : 0;
+	size_t log_len = LOG_LENGTH(doc_name->len, evicted_len);
+	response_t *rsp = create_response(log_len, response_len);
+
+	if (hit)
+		snprintf(rsp->server_log, log_len, LOG_HIT, doc_name->str);
+	else if (evicted_doc)
+		snprintf(rsp->server_log, log_len, LOG_EVICT, doc_name->str,
+				 evicted_doc->name->str);
+	else
+		snprintf(rsp->server_log, log_len, LOG_MISS, doc_name->str);
 	rsp->server_id = s->id;
 
+	return rsp;
+}
 
-	// Create the file which will put in the data base and in the cache.
-	doc_t *file = init_doc(doc_name, doc_content);
-
-	// Put the file in the server's data base.
-	db_add_doc(s, file);
+response_t *server_edit_document(server_t *s, doc_name_t *doc_name,
+								 blob_t *content)
+{
+	// Write the file in the server's data base. (Find out if the doc
+	// existed before.)
+	bool replaced;
+	doc_t *file = db_write_doc(s, doc_name, content, &replaced);
+
+	// Put the file in the cache. (Find out if it was there.)
+	doc_t *evicted_doc = NULL;
+	bool hit = lru_cache_put(s->cache, file, &evicted_doc);
+	// The doc which left the cache becomes cold.
+	if (evicted_doc)
+		server_compress_doc(s, evicted_doc);
 
-	// Put the file in the cache.
-	char *evicted_doc_name = NULL;
-	lru_cache_put(s->cache, doc_name, &file, (void **)&evicted_doc_name);
+	// Do the response.
+	size_t response_len = RESPONSE_LENGTH(doc_name->len);
+	response_t *rsp = server_cache_response(s, doc_name, hit, evicted_doc,
+											response_len);
+	snprintf(rsp->server_response, response_len,
+			 (hit || replaced) ? MSG_B : MSG_C, doc_name->str);
 
-	// Actualize the log if it's the case.
-	if (evicted_doc_name)
-		sprintf(rsp->server_log, LOG_EVICT, doc_name, evicted_doc_name);
+	// Return the response.
+	return rsp;
+}
 
-	// Free the unncecesary memory.
-	free(evicted_doc_name);
+response_t *server_fold_edit(server_t *s, request_t *req)
+{
+	doc_name_t *doc_name = req->doc_name;
+
+	// Use the doc in cache, like the edit would do. The doc is already
+	// in the database.
+	flat_entry_t *entry = flat_table_find(s->local_db, doc_name,
+										  doc_name->hash);
+	doc_t *file = (doc_t *)entry->value;
+	doc_t *evicted_doc = NULL;
+	bool hit = lru_cache_put(s->cache, file, &evicted_doc);
+	// The doc which left the cache becomes cold.
+	if (evicted_doc)
+		server_compress_doc(s, evicted_doc);
+
+	// Do the response. The doc could be created by this edit (if it
+	// was written earlier), and then it wasn't in cache before.
+	size_t response_len = RESPONSE_LENGTH(doc_name->len);
+	response_t *rsp = server_cache_response(s, doc_name,
+											hit && !req->creates_doc,
+											evicted_doc, response_len);
+	snprintf(rsp->server_response, response_len,
+			 req->creates_doc ? MSG_C : MSG_B, doc_name->str);
 
 	// Return the response.
 	return rsp;
 }
 
-response_t *server_get_document(server_t *s, char *doc_name)
+response_t *server_get_document(server_t *s, doc_name_t *doc_name)
 {
-	// Do the response.
-	response_t *rsp = create_response();
-	rsp->server_id = s->id;
-
-	// Create the log message and verify if the document is in the server.
-	if (lru_cache_has_key(s->cache, doc_name)) {
-		sprintf(rsp->server_log, LOG_HIT, doc_name);
-	} else {
-		if (!ht_has_key(*s->local_db, doc_name)) {
-			// If the document doesn't exist, will create also
-			// the response message and will exit from the function.
-			sprintf(rsp->server_log, LOG_FAULT, doc_name);
-			free(rsp->server_response);
-			rsp->server_response = NULL;
-			return rsp;
-		} else {
-			// Will update the log later if the cache is full
-			// and the curent doc isn't in cache.
-			sprintf(rsp->server_log, LOG_MISS, doc_name);
-		}
+	// Verify if the document is in the server. (The cache keeps the
+	// same docs, so it's the only search.)
+	flat_entry_t *entry = flat_table_find(s->local_db, doc_name,
+										  doc_name->hash);
+	if (!entry) {
+		// If the document doesn't exist, will create also
+		// the response message and will exit from the function.
+		size_t log_len = LOG_LENGTH(doc_name->len, 0);
+		response_t *rsp = create_response(log_len, 0);
+		snprintf(rsp->server_log, log_len, LOG_FAULT, doc_name->str);
+		rsp->server_response = NULL;
+		rsp->server_id = s->id;
+		return rsp;
 	}
 
-	// Find the pointer to the wanted doc.
-	doc_t *file = *(doc_t **)ht_get(*s->local_db, doc_name);
-
-	// Create the response message.
-	strcpy(rsp->server_response, file->content);
+	// A cold doc is decompressed first.
+	doc_t *file = (doc_t *)entry->value;
+	server_unpack_doc(s, file);
 
-	// Put the file in the cache.
-	char *evicted_doc_name;
-	lru_cache_put(s->cache, doc_name, &file, (void **)&evicted_doc_name);
+	// Put the file in the cache (or make it the most recent one).
+	doc_t *evicted_doc = NULL;
+	bool hit = lru_cache_put(s->cache, file, &evicted_doc);
+	// The doc which left the cache becomes cold.
+	if (evicted_doc)
+		server_compress_doc(s, evicted_doc);
 
-	// Actualize the log if it's the case.
-	if (evicted_doc_name)
-		sprintf(rsp->server_log, LOG_EVICT, doc_name, evicted_doc_name);
-
-	// Free the unncecesary memory.
-	free(evicted_doc_name);
+	// Make the log (the cache could be full). The response message is
+	// the content of the doc. (It isn't copied; the response keeps a
+	// reference to it until it's printed.)
+	response_t *rsp = server_cache_response(s, doc_name, hit, evicted_doc, 0);
+	rsp->content = blob_get(file->content);
 
 	// Return the response.
 	return rsp;
 }
 
-// Resolve all tasks / requests from queue.
-void do_tasks_from_queue(server_t *s)
+void db_write_pending_edit(server_t *s, doc_name_t *doc_name)
 {
-	while (!q_is_empty(s->task_queue)) {
+	// Verify if the doc has pending edits.
+	request_t *last = (request_t *)flat_table_remove(s->pending_edits,
+													 doc_name, doc_name->hash);
+	if (!last)
+		return;
+
+	// Write the content of the last edit. The edits from queue will
+	// find the doc written.
+	bool replaced;
+	db_write_doc(s, doc_name, last->content, &replaced);
+}
+
+void do_tasks_from_queue_batch(server_t *s, u_int max_tasks)
+{
+	for (u_int i = 0; i < max_tasks && !q_is_empty(s->task_queue); ++i) {
 		// Take the first request from q.
 		request_t *req = (request_t *)q_front(s->task_queue);
-		// Do the request.
-		response_t *rsp = server_edit_document(s, req->doc_name,
-						req->doc_content);
+		response_t *rsp;
+
+		// The first edit of a doc writes directly the content of the
+		// last edit of the doc. The next ones find the doc written.
+		// (The response comes from the request, which knows if it
+		// creates the doc, not from the database, which could already
+		// have the doc written by a targeted flush.)
+		request_t *last = (request_t *)flat_table_remove(s->pending_edits,
+														 req->doc_name,
+														 req->doc_name->hash);
+		if (last) {
+			bool replaced;
+			db_write_doc(s, req->doc_name, last->content, &replaced);
+		}
+		rsp = server_fold_edit(s, req);
 		// Print the response of the request.
 		PRINT_RESPONSE(rsp);
 		// Eliminate the request from q.
 		q_dequeue(s->task_queue);
+		// The task doesn't wait anymore.
+		if (s->mom->unflushed_tasks)
+			s->mom->unflushed_tasks--;
 	}
 }
 
+// Resolve all tasks / requests from queue.
+void do_tasks_from_queue(server_t *s)
+{
+	do_tasks_from_queue_batch(s, q_get_size(s->task_queue));
+}
+
 response_t *server_handle_request(server_t *s, request_t *req)
 {
 	// EDIT request
@@ -311,13 +476,35 @@ response_t *server_handle_request(server_t *s, request_t *req)
 		// to make it later.
 		request_t *req_dup = duplicate_request(req);
 
-		// Put the duplicate request in q.
-		q_enqueue(s->task_queue, &req_dup);
+		// Put the duplicate request in q. (The queue grows, so the
+		// request isn't lost even if there are a lot of edits.)
+		q_enqueue(s->task_queue, req_dup);
+
+		// Remember it as the last edit of the doc. The content of the
+		// previous edit won't be written, so it can be given back.
+		doc_name_t *doc_name = req->doc_name;
+		flat_entry_t *last = flat_table_find(s->pending_edits, doc_name,
+											 doc_name->hash);
+		req_dup->creates_doc = !last && !flat_table_find(s->local_db,
+														 doc_name,
+														 doc_name->hash);
+		if (last) {
+			request_t *last_req = (request_t *)last->value;
+			blob_put(last_req->content);
+			last_req->content = NULL;
+			last->value = req_dup;
+		} else {
+			flat_table_put(s->pending_edits, doc_name, doc_name->hash,
+						   req_dup);
+		}
 
 		// Make the response.
-		response_t *rsp = create_response();
-		sprintf(rsp->server_log, LOG_LAZY_EXEC, s->task_queue->size);
-		sprintf(rsp->server_response, MSG_A, "EDIT", req->doc_name);
+		size_t log_len = LOG_LENGTH(0, 0);
+		size_t response_len = RESPONSE_LENGTH(doc_name->len);
+		response_t *rsp = create_response(log_len, response_len);
+		snprintf(rsp->server_log, log_len, LOG_LAZY_EXEC, s->task_queue->size);
+		snprintf(rsp->server_response, response_len, MSG_A, "EDIT",
+				 doc_name->str);
 		rsp->server_id = s->id;
 
 		// Return the response.
@@ -326,8 +513,17 @@ response_t *server_handle_request(server_t *s, request_t *req)
 
 	// GET request
 	if (req->type == 1) {
-		// Resolve all (edit) requests from the task queue.
-		do_tasks_from_queue(s);
+		if (s->targeted_flush) {
+			// Resolve just a batch of the oldest requests and write
+			// the pending content of the wanted doc. All the requests
+			// from queue must be done until the end.
+			s->mom->unflushed_tasks = q_get_size(s->task_queue);
+			do_tasks_from_queue_batch(s, TASK_FLUSH_BATCH);
+			db_write_pending_edit(s, req->doc_name);
+		} else {
+			// Resolve all (edit) requests from the task queue.
+			do_tasks_from_queue(s);
+		}
 		// Do the get request and return its response.
 		return server_get_document(s, req->doc_name);
 	}
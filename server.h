@@ -5,14 +5,41 @@
 #include <stdio.h>
 #include "server.h"
 #include "lru_cache.h"
-#include "hash_map.h"
+#include "flat_table.h"
 #include "queue.h"
+#include "doc_index.h"
+#include "mem_pool.h"
+#include "blob.h"
 #include "utils.h"
 #include "constants.h"
 
-#define TASK_QUEUE_SIZE         1000
-#define MAX_LOG_LENGTH          1000
-#define MAX_RESPONSE_LENGTH     4096
+/* The initial capacity of the task queue (it grows when needed). */
+#define TASK_QUEUE_SIZE         16
+/* The number of edits done by a GET with the targeted flush. */
+#define TASK_FLUSH_BATCH        8
+/* The longest log is LOG_EVICT, with 2 names of docs (of the given
+lengths). */
+#define LOG_LENGTH(name_len, evicted_len) \
+	(sizeof(LOG_EVICT) + (name_len) + (evicted_len))
+/* The longest message (which isn't the content of a doc) is MSG_A. */
+#define RESPONSE_LENGTH(name_len) \
+	(sizeof(MSG_A) + REQUEST_TYPE_LENGTH + (name_len))
+
+/******************************
+ * The statistics of the compression of the cold docs of a server
+ * (see server_compress_doc()).
+*******************************/
+typedef struct server_stats_t {
+	/* The number of contents which were compressed. */
+	u_int packed_docs;
+	/* The bytes of those contents, before and after the compression. */
+	uint64_t raw_bytes;
+	uint64_t packed_bytes;
+	/* The number of contents which were decompressed (by the GETs). */
+	u_int unpacked_docs;
+	/* The time spent with the decompressions, in nanoseconds. */
+	uint64_t unpack_ns;
+} server_stats_t;
 
 /******************************
  * Structure to save the informtions
@@ -21,15 +48,45 @@
 typedef struct server_t {
 	/* The cache. */
 	struct lru_cache_t *cache;
-	/* Pointer to the local data base in which we save
-	pairs of next type: doc's name - doc's contnet. */
-	struct hashtable_t **local_db;
+	/* The local data base in which we save pairs of next
+	type: doc's name - doc (doc_t *). The names are interned, so
+	they are compared after their addresses. */
+	struct flat_table_t *local_db;
+	/* The index which keeps the docs from the local data base
+	sorted after their position on the hash ring. */
+	struct doc_index_t *doc_index;
 	/* The queue of requests.*/
 	struct queue_t *task_queue;
+	/* The pending edits: pairs doc's name - the last edit
+	of the doc from the task queue (request_t *). */
+	struct flat_table_t *pending_edits;
 	/* The id of the server. */
 	u_int id;
-	/* The hash of the server's id.*/
+	/* The index of the replica (0 -> the server which owns the
+	resources; the replicas have the same id as it). */
+	u_int replica_idx;
+	/* The hash of the server's id and replica (see hash_replica()). */
 	u_int hash_id;
+	/* The server which owns the resources used by this one
+	(itself, if it isn't a replica of other server). */
+	struct server_t *mom;
+	/* The worker thread which does the requests of the server
+	(-1, if it wasn't chosen yet). See worker.h. */
+	int worker;
+	/* true -> a GET doesn't empty the task queue; it writes just the
+	pending content of its doc (see server_handle_request()) */
+	bool targeted_flush;
+	/* The number of tasks from the queue which a GET would have done
+	without the targeted flush (they are done at the end, see
+	loader_flush_servers()). Used only by the server which owns the
+	resources. */
+	u_int unflushed_tasks;
+	/* true -> the docs which leave the cache or which are moved
+	from other server are compressed (see server_compress_doc()) */
+	bool compress;
+	/* The statistics of the compression (used only by the server
+	which owns the resources). */
+	server_stats_t stats;
 } server_t;
 
 /******************************
@@ -39,12 +96,19 @@ typedef struct server_t {
 typedef struct request_t {
 	/* The request's type. */
 	request_type type;
-	/* The name of the file about
-	which we are interesetd. */
-	char *doc_name;
+	/* The name of the file about which we are interesetd
+	(interned by the load balancer; it has also the hash). */
+	doc_name_t *doc_name;
 	/* The content of the file if we want
-	to edit a document. */
+	to edit a document (points in the input). */
 	char *doc_content;
+	/* The content as a blob, which is shared with the doc written by
+	the edit (set when the edit is put in queue; NULL if a later edit
+	of the doc gives the content). */
+	blob_t *content;
+	/* true -> the doc didn't exist when the edit was put in queue
+	and no other edit of it was waiting (the edit creates the doc) */
+	bool creates_doc;
 } request_t;
 
 /******************************
@@ -52,14 +116,23 @@ typedef struct request_t {
  * of the repsponse of a request.
 *******************************/
 typedef struct response_t {
+	/* The log (points in buff). */
 	char *server_log;
+	/* The response: points in buff (NULL -> the doc of a GET
+	doesn't exist; not used if there is a content). */
 	char *server_response;
+	/* For a GET, the content of the doc, which is the response. The
+	response has a reference to it, so it stays valid even if the doc
+	is edited. */
+	blob_t *content;
 	int server_id;
+	/* The buffer where are formatted the log and the response. It's
+	allocated after the structure, with the length of the names of
+	the docs, so no message is cut. */
+	char buff[];
 } response_t;
 
 
-hashtable_t *ht_redistribute(hashtable_t *old_ht, int new_hmax);
-
 /******************************
  * free_request() - Free the memory of a request.
  *
@@ -68,13 +141,11 @@ hashtable_t *ht_redistribute(hashtable_t *old_ht, int new_hmax);
 void free_request(void *r);
 
 /******************************
- * key_doc_free_function() - Free the memory of a pair from hashtable,
- * 		in which the key is a simple type of data and the value is of
- *		type doc_t*.
+ * free_doc() - Free the memory of a document and of its fields.
  *
- * @param data: The pair from hashtable.
+ * @param d: Document's address.
 ******************************/
-void key_doc_free_function(void *data);
+void free_doc(void *d);
 
 /******************************
  * @brief Duplicate the given request and return that coppy.
@@ -83,29 +154,30 @@ request_t *duplicate_request(request_t *req);
 
 /******************************
  * create_response() - Allocate memory for a structure of type
- * 		response and its fields.
+ * 		response. Its messages are written in the buffer which is
+ * 		allocated after the structure.
+ *
+ * @param log_len: The number of bytes for the log (see LOG_LENGTH).
+ * @param response_len: The number of bytes for the response (see
+ * 		RESPONSE_LENGTH).
  *
  * @return - The created response.
 *******************************/
-response_t *create_response();
+response_t *create_response(size_t log_len, size_t response_len);
 
 /******************************
-* db_resdistribute_docs() - Change the number of buckets from the hashtbale
-*		of a database. Also, the documents are redistributed in hashmap.
-*
-* @param old_db: The database which we must modify.
-* @param new_hmax: The new number of buckets. 
-*
-* @return: The updated hashtable.
+ * @brief Free the memory of a response and of its fields.
 *******************************/
-hashtable_t *db_redistribute_docs(hashtable_t *old_db, int new_hmax);
+void free_response(response_t *rsp);
 
 /******************************
-* @brief Increase the number of buckets from the hashtable of a database
-*		and return the updated hashmap. The new number of buckets it's
-* 		the closest primer number of the product old number of buckets * 10.
+ * write_response() - Write a response in the output (called by
+ *		PRINT_RESPONSE). The content of a doc is written directly from
+ *		its blob, chunk by chunk.
+ *
+ * @param rsp: The response.
 *******************************/
-hashtable_t *db_increase_hmax(hashtable_t *db);
+void write_response(response_t *rsp);
 
 /******************************
  * db_add_doc() - Add a document in the local database of a
@@ -115,8 +187,28 @@ hashtable_t *db_increase_hmax(hashtable_t *db);
  * @param file: Document which will be added.
  *		(The doc is put how is received - It's
  *		not put a coppy of it.)
+ *
+ * @return - true, if an older version of the doc was replaced
+ *			 false, if the doc is new
+*******************************/
+bool db_add_doc(server_t *s, doc_t *file);
+
+/******************************
+ * db_write_doc() - Write a content in a document from the local
+ *		database of a server. An existing doc receives the new blob
+ *		in place, so it isn't taken out from the database, the index
+ *		or the cache.
+ *
+ * @param s: Server with wich we work.
+ * @param doc_name: The name of the document.
+ * @param content: The new content of the doc (the doc takes
+ *		a reference to it).
+ * @param replaced: Set to true if the doc existed, else to false.
+ *
+ * @return - The written doc.
 *******************************/
-void db_add_doc(server_t *s, doc_t *file);
+doc_t *db_write_doc(server_t *s, doc_name_t *doc_name, blob_t *content,
+					bool *replaced);
 
 /******************************
  * db_remove_doc() - Remove a document from the local database of
@@ -126,17 +218,57 @@ void db_add_doc(server_t *s, doc_t *file);
  * @param doc_name: Name of the document
  *		which will be removed.
 *******************************/
-void db_remove_doc(server_t *s, char *doc_name);
+void db_remove_doc(server_t *s, doc_name_t *doc_name);
+
+/******************************
+ * db_take_docs() - Take out from the local database of a server,
+ *		without to free them, the documents whose hashes are from
+ *		the arc [hash_lo, hash_hi) of the ring. (See doc_index_extract().)
+ *
+ * @param s: Server with wich we work.
+ * @param hash_lo: The start of the arc.
+ * @param hash_hi: The end of the arc.
+ *
+ * @return - The documents in a list linked using the field idx_right.
+*******************************/
+doc_t *db_take_docs(server_t *s, u_int hash_lo, u_int hash_hi);
+
+/******************************
+ * doc_set_content() - Give a new content to a doc. The doc takes
+ *		a reference to the new blob and gives back the old one (which
+ *		may still be used by a response).
+ *
+ * @param file: The document.
+ * @param content: The new content.
+*******************************/
+void doc_set_content(doc_t *file, blob_t *content);
+
+/******************************
+ * server_compress_doc() - Compress the content of a cold doc (a doc
+ *		which left the cache or which was moved in the server), if the
+ *		compression is enabled. The doc is decompressed by the next GET.
+ *
+ * @param s: Server with wich we work.
+ * @param file: The document.
+*******************************/
+void server_compress_doc(server_t *s, doc_t *file);
+
+/******************************
+ * @brief Add the statistics from src in dst.
+*******************************/
+void server_stats_add(server_stats_t *dst, const server_stats_t *src);
 
 /******************************
  * init_doc() - Create and initialize a doc.
  *
- * @param doc_name: The name of the documnet.
- * @param doc_content: The content of the document.
+ * @param doc_name: The name of the documnet (interned - it
+ *		isn't copied).
+ * @param content: The content of the document (the doc takes
+ *		a reference to it).
  *
  * @return - The created doc.
 *******************************/
-doc_t *init_doc(char *doc_name, char *doc_content);
+doc_t *init_doc(doc_name_t *doc_name, blob_t *content);
 
 /******************************
  * init_server() - Create and initialize a server.
@@ -169,12 +301,36 @@ void free_server(server_t **s);
  * @param s: Server with wich we work.
  * @param doc_name: The name of the document
  *		which will be edited.
- * @param doc_content: The new content of the doc.
+ * @param content: The new content of the doc.
+ *
+ * @return response_t*: Response of the edit operation.
+*******************************/
+response_t *server_edit_document(server_t *s, doc_name_t *doc_name,
+								 blob_t *content);
+
+/******************************
+ * server_fold_edit() - Do an edit of a doc which was already written
+ *		with the content of its last edit from the task queue. Just the
+ *		response is made and the doc is used in cache; the doc isn't
+ *		created again. The response says if the request created the
+ *		doc (req->creates_doc), whatever the database has now.
+ *
+ * @param s: Server with wich we work.
+ * @param req: The edit request.
  *
  * @return response_t*: Response of the edit operation.
 *******************************/
-response_t
-*server_edit_document(server_t *s, char *doc_name, char *doc_content);
+response_t *server_fold_edit(server_t *s, request_t *req);
+
+/******************************
+ * db_write_pending_edit() - Write in the database the content of the
+ *		last pending edit of a doc, without to do the edits from queue.
+ *		The edits stay in queue, only to give their responses later.
+ *
+ * @param s: Server with wich we work.
+ * @param doc_name: The name of the document.
+*******************************/
+void db_write_pending_edit(server_t *s, doc_name_t *doc_name);
 
 /******************************
  * server_get_document() - Do a get operation.
@@ -185,7 +341,18 @@ response_t
  *
  * @return response_t*: Response of the get operation.
 *******************************/
-response_t *server_get_document(server_t *s, char *doc_name);
+response_t *server_get_document(server_t *s, doc_name_t *doc_name);
+
+/******************************
+ * do_tasks_from_queue_batch() - Resolve the first (edit) requests from
+ *		the task queue of a server. Every doc is written just once, with
+ *		the content of its last edit; the others edits of the doc only
+ *		give their responses (see server_fold_edit()).
+ *
+ * @param s: Server with wich we work.
+ * @param max_tasks: The maximum number of requests which are done.
+*******************************/
+void do_tasks_from_queue_batch(server_t *s, u_int max_tasks);
 
 /******************************
  * @brief Resolve all (edit) requests from task queue of
@@ -204,7 +371,11 @@ void do_tasks_from_queue(server_t *s);
  * 
  * @brief Based on the type of request, call the appropriate solvers,
  *     and execute the tasks from queue if needed (in this case, after
- *     executing each task, PRINT_RESPONSE is called).
+ *     executing each task, PRINT_RESPONSE is called). With the targeted
+ *     flush, a GET does only TASK_FLUSH_BATCH tasks and writes the
+ *     pending content of its doc, so it doesn't wait for all the queue;
+ *     the rest of the tasks which it would have done are remembered in
+ *     unflushed_tasks.
 *******************************/
 response_t *server_handle_request(server_t *s, request_t *req);
 
@@ -0,0 +1,88 @@
+// Copyright Necula Mihail 313CAa 2023-2024
+#include <stdio.h>
+#include "trace.h"
+#include "parser.h"
+#include "names.h"
+#include "utils.h"
+
+// Write some bytes in the binary trace.
+static void trace_write(FILE *out, const void *data, size_t len)
+{
+	DIE(fwrite(data, 1, len, out) != len, "fwrite() failed");
+}
+
+// Write a number in the binary trace.
+static void trace_write_u32(FILE *out, uint32_t number)
+{
+	trace_write(out, &number, sizeof(number));
+}
+
+void trace_convert(const char *text_path, const char *binary_path)
+{
+	// Open the text trace and read its header.
+	parser_t *parser = parser_open(text_path);
+	DIE(parser->binary, "the trace is already binary");
+	int requests_num;
+	unsigned int replicas;
+	parser_read_header(parser, &requests_num, &replicas);
+
+	// Create the binary trace. The header is written again at the end,
+	// when the position of the names is known.
+	FILE *out = fopen(binary_path, "wb");
+	DIE(out == NULL, "fopen() failed");
+	trace_header_t header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, TRACE_MAGIC, sizeof(header.magic));
+	header.version = TRACE_VERSION;
+	header.requests_num = (uint32_t)requests_num;
+	header.replicas = replicas;
+	trace_write(out, &header, sizeof(header));
+
+	// The ids of the names (given in the order in which the names
+	// are seen).
+	name_table_t *names = names_create(hash_string);
+
+	// Convert every request.
+	parsed_request_t req;
+	for (int i = 0; i < requests_num; ++i) {
+		parser_next_request(parser, &req);
+		uint8_t type = (uint8_t)req.type;
+		trace_write(out, &type, sizeof(type));
+
+		if (req.type == ADD_SERVER) {
+			trace_write_u32(out, (uint32_t)req.server_id);
+			trace_write_u32(out, (uint32_t)req.cache_size);
+			trace_write_u32(out, (uint32_t)req.weight);
+		} else if (req.type == REMOVE_SERVER) {
+			trace_write_u32(out, (uint32_t)req.server_id);
+		} else {
+			trace_write_u32(out, names_intern(names, req.doc_name, -1)->id);
+			if (req.type == EDIT_DOCUMENT) {
+				uint32_t len = (uint32_t)strlen(req.doc_content);
+				trace_write_u32(out, len);
+				trace_write(out, req.doc_content, len + 1);
+			}
+		}
+	}
+
+	// Write the names of the docs.
+	long names_offset = ftell(out);
+	DIE(names_offset < 0, "ftell() failed");
+	for (uint32_t i = 0; i < names->size; ++i) {
+		char *name = names->names[i]->str;
+		uint32_t len = (uint32_t)strlen(name);
+		trace_write_u32(out, len);
+		trace_write(out, name, len + 1);
+	}
+
+	// Complete the header.
+	header.names_offset = (uint64_t)names_offset;
+	header.names_count = names->size;
+	DIE(fseek(out, 0, SEEK_SET) != 0, "fseek() failed");
+	trace_write(out, &header, sizeof(header));
+
+	// Free the memory.
+	DIE(fclose(out) != 0, "fclose() failed");
+	names_free(&names);
+	parser_close(&parser);
+}
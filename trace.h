@@ -0,0 +1,60 @@
+// Copyright Necula Mihail 313CAa 2023-2024
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdint.h>
+
+/******************************
+ * The binary format of a trace (all the numbers are uint32_t, in the
+ * byte order of the machine, without alignment):
+ *
+ * - the header (trace_header_t)
+ * - the requests, every one starting with a byte which is its type:
+ *		ADD_SERVER:    id, cache_size, weight
+ *		REMOVE_SERVER: id
+ *		GET_DOCUMENT:  name_id
+ *		EDIT_DOCUMENT: name_id, content_length, the bytes of the
+ *					   content and a '\0'
+ * - the names of the docs, in the order of their ids: length,
+ *		the bytes of the name and a '\0'
+ *
+ * The strings end with '\0', so they can be used directly from
+ * the mapped file.
+*******************************/
+
+/* The first bytes of a binary trace. */
+#define TRACE_MAGIC		"SRVT"
+/* The version of the format. */
+#define TRACE_VERSION	1
+
+/******************************
+ * The header of a binary trace.
+*******************************/
+typedef struct trace_header_t {
+	/* TRACE_MAGIC (without '\0'). */
+	char magic[4];
+	/* TRACE_VERSION. */
+	uint32_t version;
+	/* The number of requests. */
+	uint32_t requests_num;
+	/* The number of replicas of a server. */
+	uint32_t replicas;
+	/* The offset in file of the names of the docs. */
+	uint64_t names_offset;
+	/* The number of names of docs. */
+	uint32_t names_count;
+	/* Unused (keeps the size a multiple of 8). */
+	uint32_t reserved;
+} trace_header_t;
+
+/******************************
+ * trace_convert() - Convert a trace from the text format in the
+ *		binary format. Every name of doc is written once and the
+ *		requests use its id.
+ *
+ * @param text_path: The path of the text trace.
+ * @param binary_path: The path of the binary trace which is created.
+*******************************/
+void trace_convert(const char *text_path, const char *binary_path);
+
+#endif
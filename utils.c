@@ -24,6 +24,86 @@ unsigned int hash_string(void *key)
     return hash;
 }
 
+/* The constants of wyhash. */
+#define WY_P0   0xa0761d6478bd642full
+#define WY_P1   0xe7037ed1a0b428dbull
+#define WY_P2   0x8ebc6af09c88c6e3ull
+
+/* Multiply 2 numbers on 128 bits and mix the halves of the result. */
+static inline uint64_t wy_mum(uint64_t a, uint64_t b)
+{
+    __uint128_t r = (__uint128_t)a * b;
+
+    return (uint64_t)r ^ (uint64_t)(r >> 64);
+}
+
+/* Read 8 bytes which may be unaligned. */
+static inline uint64_t wy_read64(const unsigned char *p)
+{
+    uint64_t v;
+
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+unsigned int hash_uint_wy(void *key)
+{
+    uint64_t h = wy_mum(*((unsigned int *)key) ^ WY_P0, WY_P1);
+
+    return (unsigned int)(h ^ (h >> 32));
+}
+
+unsigned int hash_string_wy(void *key)
+{
+    const unsigned char *p = (const unsigned char *) key;
+    size_t len = strlen((const char *) key);
+    uint64_t h = WY_P0 ^ len;
+
+    /* The bulk of the name, 16 bytes at a time */
+    for (; len > 16; len -= 16, p += 16)
+        h = wy_mum(wy_read64(p) ^ WY_P1, wy_read64(p + 8) ^ h);
+
+    /* The last (at most 16) bytes, without to read after the name */
+    unsigned char tail[16] = {0};
+    memcpy(tail, p, len);
+    h = wy_mum(wy_read64(tail) ^ WY_P1, wy_read64(tail + 8) ^ h);
+    h = wy_mum(h ^ WY_P2, len ^ WY_P1);
+
+    return (unsigned int)(h ^ (h >> 32));
+}
+
+/* The constant of the golden ratio, which spreads a small number. */
+#define REPLICA_MIX     0x9e3779b9u
+
+unsigned int hash_replica(unsigned int (*hash_servers)(void *),
+                          unsigned int server_id, unsigned int replica_idx)
+{
+    unsigned int key = hash_servers(&server_id);
+
+    /* The first replica is placed like a server without replicas */
+    if (!replica_idx)
+        return key;
+
+    /* The index is spread on all the bits before the pair is hashed */
+    key ^= replica_idx * REPLICA_MIX;
+    return hash_servers(&key);
+}
+
+const hash_family_t hash_families[] = {
+    {"djb2", hash_uint, hash_string},
+    {"wyhash", hash_uint_wy, hash_string_wy},
+    {NULL, NULL, NULL},
+};
+
+const hash_family_t *get_hash_family(const char *name)
+{
+    for (const hash_family_t *f = hash_families; f->name; f++)
+        if (!strcmp(f->name, name))
+            return f;
+
+    return NULL;
+}
+
 char *get_request_type_str(request_type req_type) {
     switch (req_type) {
     case ADD_SERVER:
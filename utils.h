@@ -3,11 +3,13 @@
 #define UTILS_H
 
 #include <errno.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
 #include "constants.h"
+#include "output.h"
 
 #define DIE(assertion, call_description)                                      \
     do {                                                                      \
@@ -20,12 +22,8 @@
 
 #define PRINT_RESPONSE(response_ptr) ({                                       \
     if (response_ptr) {                                                       \
-        printf(GENERIC_MSG, response_ptr->server_id,                          \
-            response_ptr->server_response, response_ptr->server_id,           \
-            response_ptr->server_log);                                        \
-        free(response_ptr->server_response);                                  \
-        free(response_ptr->server_log);                                       \
-        free(response_ptr);}                                                  \
+        write_response(response_ptr);                                         \
+        free_response(response_ptr);}                                         \
     })
 
 
@@ -41,6 +39,60 @@ unsigned int hash_uint(void *key);
 *******************************/
 unsigned int hash_string(void *key);
 
+/******************************
+ * @brief Hash of a server ID in the style of wyhash: the id is
+ *      multiplied with a constant on 128 bits and the halves are mixed.
+*******************************/
+unsigned int hash_uint_wy(void *key);
+
+/******************************
+ * @brief Hash of a document name in the style of wyhash: the name is
+ *      read 8 bytes at a time and every 16 bytes are mixed with a
+ *      128-bit multiplication.
+*******************************/
+unsigned int hash_string_wy(void *key);
+
+/******************************
+ * hash_replica() - Find the position on the hash ring of a replica
+ *      (virtual node) of a server. The pair (server_id, replica_idx)
+ *      is hashed, so the replicas don't need ids of their own.
+ *
+ * @param hash_servers: The hash function of the server IDs.
+ * @param server_id: The id of the server.
+ * @param replica_idx: The index of the replica (0 -> the server itself,
+ *      which has the hash of its id).
+ *
+ * @return - The hash of the replica.
+*******************************/
+unsigned int hash_replica(unsigned int (*hash_servers)(void *),
+                          unsigned int server_id, unsigned int replica_idx);
+
+/******************************
+ * A pair of hash functions which can be used by a load balancer
+ * (see hash_families in utils.c).
+*******************************/
+typedef struct hash_family_t {
+    /* The name used to choose the family (--hash <name>). */
+    const char *name;
+    /* The hash of a server ID. */
+    unsigned int (*hash_servers)(void *);
+    /* The hash of a document name. */
+    unsigned int (*hash_docs)(void *);
+} hash_family_t;
+
+/* The known families; the first one is the default. The array
+ends with a family without name. */
+extern const hash_family_t hash_families[];
+
+/******************************
+ * get_hash_family() - Find a family of hash functions.
+ *
+ * @param name: The name of the family.
+ *
+ * @return - The family or NULL, if it doesn't exist.
+*******************************/
+const hash_family_t *get_hash_family(const char *name);
+
 char *get_request_type_str(request_type req_type);
 request_type get_request_type(char *request_type_str);
 
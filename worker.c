@@ -0,0 +1,167 @@
+// Copyright Necula Mihail 313CAa 2023-2024
+#include <errno.h>
+#include "worker.h"
+
+// Do the jobs from the inbound queue of a worker, one by one.
+static void *worker_loop(void *arg)
+{
+	worker_t *w = (worker_t *)arg;
+	worker_pool_t *pool = w->pool;
+
+	while (1) {
+		// Sleep until a job is put in queue (or the worker is stopped).
+		while (sem_wait(&w->pending) && errno == EINTR)
+			;
+		worker_slot_t *slot = (worker_slot_t *)lfq_pop(w->jobs);
+
+		// Woken up without a job -> the worker was stopped.
+		if (!slot)
+			break;
+
+		// Do the request. Its responses (also the ones of the edits done
+		// from the task queue) are captured in the slot of the request.
+		output_capture(&slot->out);
+		job_t *job = &slot->job;
+		response_t *rsp = server_handle_request(job->srv, &job->req);
+		PRINT_RESPONSE(rsp);
+		output_capture(NULL);
+
+		// Let the load balancer know that the responses are ready.
+		atomic_store_explicit(&slot->ready, true, memory_order_release);
+		sem_post(&pool->done);
+	}
+
+	return NULL;
+}
+
+// Write the responses of the request from the front of the window.
+// If block is false and they aren't ready, return false.
+static bool worker_pool_write_next(worker_pool_t *pool, bool block)
+{
+	worker_slot_t *slot = &pool->slots[pool->written & (WORKER_WINDOW - 1)];
+
+	while (!atomic_load_explicit(&slot->ready, memory_order_acquire)) {
+		if (!block)
+			return false;
+		// A job was done; verify again if it was this one.
+		while (sem_wait(&pool->done) && errno == EINTR)
+			;
+	}
+
+	output_write(slot->out.buff, slot->out.size);
+	slot->out.size = 0;
+	atomic_store_explicit(&slot->ready, false, memory_order_relaxed);
+	pool->written++;
+
+	// Count the job as written, so the semaphore doesn't grow forever.
+	// (If the worker didn't post yet, the extra post just wakes up
+	// once more the load balancer, which verifies again.)
+	sem_trywait(&pool->done);
+
+	return true;
+}
+
+worker_pool_t *worker_pool_create(u_int workers_num)
+{
+	// Allocate memory for the pool's structure.
+	worker_pool_t *pool = (worker_pool_t *)malloc(sizeof(worker_pool_t));
+	DIE(pool == NULL, "malloc() failed\n");
+
+	// Allocate the window of responses. Its buffers grow when needed.
+	pool->slots = (worker_slot_t *)calloc(WORKER_WINDOW,
+										  sizeof(worker_slot_t));
+	DIE(pool->slots == NULL, "calloc() failed\n");
+	for (u_int i = 0; i < WORKER_WINDOW; ++i) {
+		pool->slots[i].out.fd = -1;
+		atomic_init(&pool->slots[i].ready, false);
+	}
+
+	// Initialize the parameters of the pool.
+	pool->workers_num = workers_num ? workers_num : 1;
+	pool->next_worker = 0;
+	pool->seq = 0;
+	pool->written = 0;
+	DIE(sem_init(&pool->done, 0, 0), "sem_init() failed\n");
+
+	// Start the workers.
+	pool->workers = (worker_t *)malloc(pool->workers_num * sizeof(worker_t));
+	DIE(pool->workers == NULL, "malloc() failed\n");
+	for (u_int i = 0; i < pool->workers_num; ++i) {
+		worker_t *w = &pool->workers[i];
+		w->jobs = lfq_create(WORKER_WINDOW);
+		DIE(sem_init(&w->pending, 0, 0), "sem_init() failed\n");
+		w->pool = pool;
+		errno = pthread_create(&w->thread, NULL, worker_loop, w);
+		DIE(errno, "pthread_create() failed\n");
+	}
+
+	// Return the created pool.
+	return pool;
+}
+
+void worker_pool_dispatch(worker_pool_t *pool, server_t *srv, request_t *req)
+{
+	// Make place in the window, if it's full.
+	if (pool->seq - pool->written == WORKER_WINDOW)
+		worker_pool_write_next(pool, true);
+
+	// The servers are given to the workers in turn, when they receive
+	// their first request. (The replicas use the worker of their mom.)
+	server_t *mom = srv->mom;
+	if (mom->worker < 0)
+		mom->worker = (int)(pool->next_worker++ % pool->workers_num);
+	worker_t *w = &pool->workers[mom->worker];
+
+	// Prepare the job in its slot, which is free.
+	worker_slot_t *slot = &pool->slots[pool->seq & (WORKER_WINDOW - 1)];
+	slot->job.srv = srv;
+	slot->job.req = *req;
+	slot->job.seq = pool->seq++;
+
+	// Put the job in the queue of the worker. If the queue is full,
+	// write the oldest responses until the worker makes place.
+	while (!lfq_push(w->jobs, slot))
+		worker_pool_write_next(pool, true);
+	sem_post(&w->pending);
+
+	// Write the responses which are ready, without to wait.
+	while (pool->written != pool->seq && worker_pool_write_next(pool, false))
+		;
+}
+
+void worker_pool_wait(worker_pool_t *pool)
+{
+	while (pool->written != pool->seq)
+		worker_pool_write_next(pool, true);
+}
+
+void worker_pool_free(worker_pool_t **pool)
+{
+	// Get the pool's address.
+	worker_pool_t *p = *pool;
+
+	// Write the remaining responses.
+	worker_pool_wait(p);
+
+	// Stop the workers. (Their queues are empty now.)
+	for (u_int i = 0; i < p->workers_num; ++i) {
+		worker_t *w = &p->workers[i];
+		sem_post(&w->pending);
+		pthread_join(w->thread, NULL);
+		sem_destroy(&w->pending);
+		lfq_free(w->jobs);
+	}
+	free(p->workers);
+
+	// Free the memory of the window.
+	for (u_int i = 0; i < WORKER_WINDOW; ++i)
+		free(p->slots[i].out.buff);
+	free(p->slots);
+	sem_destroy(&p->done);
+
+	// Free the memory of the pool's structure.
+	free(p);
+
+	// Lose the address of the pool, which doesn't exist anymore.
+	*pool = NULL;
+}
@@ -0,0 +1,114 @@
+// Copyright Necula Mihail 313CAa 2023-2024
+#ifndef WORKER_H
+#define WORKER_H
+
+#include <pthread.h>
+#include <semaphore.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include "server.h"
+#include "output.h"
+
+/* The maximum number of requests which can be in work in the same time
+(a power of 2). Also the capacity of the inbound queue of a worker. */
+#define WORKER_WINDOW		4096
+
+/******************************
+ * A request sent to a worker.
+*******************************/
+typedef struct job_t {
+	/* The replica which received the request. */
+	server_t *srv;
+	/* The request (its strings point in the input file). */
+	request_t req;
+	/* The number of the request in the order of the input. */
+	u_int seq;
+} job_t;
+
+/******************************
+ * The place of a request in the window: the job sent to the worker
+ * and the responses, which are kept until they are written in the
+ * order of the input.
+*******************************/
+typedef struct worker_slot_t {
+	/* The request. */
+	job_t job;
+	/* The responses, already formatted. */
+	output_t out;
+	/* true -> the request was done and the responses can be written */
+	atomic_bool ready;
+} worker_slot_t;
+
+/******************************
+ * A worker thread, which does the requests of some servers. The
+ * inbound queue is a lock-free queue with the slots of the jobs.
+*******************************/
+typedef struct worker_t {
+	/* The inbound queue. */
+	lf_queue_t *jobs;
+	/* Counts the jobs which weren't taken (the worker sleeps on it).
+	A post without a job stops the worker. */
+	sem_t pending;
+	/* The pool from which the worker is part. */
+	struct worker_pool_t *pool;
+	pthread_t thread;
+} worker_t;
+
+/******************************
+ * The worker threads and the window in which the responses are
+ * put back in the order of the input.
+*******************************/
+typedef struct worker_pool_t {
+	/* The workers. */
+	worker_t *workers;
+	u_int workers_num;
+	/* The worker which will receive the next new server. */
+	u_int next_worker;
+	/* The window of responses (indexed with seq % WORKER_WINDOW). */
+	worker_slot_t *slots;
+	/* The number of the next request which will be sent. */
+	u_int seq;
+	/* The number of the next request whose responses will be written. */
+	u_int written;
+	/* Counts the done jobs which weren't written (the load balancer
+	sleeps on it). */
+	sem_t done;
+} worker_pool_t;
+
+/******************************
+ * worker_pool_create() - Start the worker threads.
+ *
+ * @param workers_num: The number of threads.
+ *
+ * @return - The created pool.
+*******************************/
+worker_pool_t *worker_pool_create(u_int workers_num);
+
+/******************************
+ * worker_pool_dispatch() - Send a request to the worker of a server.
+ *		All the requests of a server are done by the same worker, in
+ *		the order in which they were sent. The responses which are
+ *		ready are written in the order of the input.
+ *
+ * @param pool: The pool with which we work.
+ * @param srv: The replica which must do the request.
+ * @param req: The request (routed by loader_route_request()).
+*******************************/
+void worker_pool_dispatch(worker_pool_t *pool, server_t *srv, request_t *req);
+
+/******************************
+ * @brief Wait until all the sent requests are done and write their
+ *		responses. After this call, the servers can be modified by
+ *		the current thread (the workers are sleeping).
+*******************************/
+void worker_pool_wait(worker_pool_t *pool);
+
+/******************************
+ * worker_pool_free() - Wait for all the requests, stop the workers and
+ *		free the memory of the pool.
+ *
+ * @param pool: Pointer to the pool's address.
+*******************************/
+void worker_pool_free(worker_pool_t **pool);
+
+#endif